@@ -1,4 +1,5 @@
 #include "BigInteger.hh"
+#include <climits>
 
 void BigInteger::operator =(const BigInteger &x) {
 	// Calls like a = a have no effect
@@ -53,18 +54,22 @@ BigInteger::BigInteger(const BigUnsigned &x, Sign s) : mag(x) {
  * negative BigInteger instead of an exception. */
 
 // Done longhand to let us use initialization.
-BigInteger::BigInteger(unsigned long  x) : mag(x) { sign = mag.isZero() ? zero : positive; }
-BigInteger::BigInteger(unsigned int   x) : mag(x) { sign = mag.isZero() ? zero : positive; }
-BigInteger::BigInteger(unsigned short x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+BigInteger::BigInteger(unsigned long long x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+BigInteger::BigInteger(unsigned long      x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+BigInteger::BigInteger(unsigned int       x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+BigInteger::BigInteger(unsigned short     x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+#ifdef __SIZEOF_INT128__
+BigInteger::BigInteger(BigUnsigned::UInt128 x) : mag(x) { sign = mag.isZero() ? zero : positive; }
+#endif
 
 // For signed input, determine the desired magnitude and sign separately.
 
 namespace {
+	/* Negating in UX rather than in X keeps the most negative X, which
+	 * negates to itself, from overflowing. */
 	template <class X, class UX>
-	BigInteger::Blk magOf(X x) {
-		/* UX(...) cast needed to stop short(-2^15), which negates to
-		 * itself, from sign-extending in the conversion to Blk. */
-		return BigInteger::Blk(x < 0 ? UX(-x) : x);
+	UX magOf(X x) {
+		return x < 0 ? UX(0) - UX(x) : UX(x);
 	}
 	template <class X>
 	BigInteger::Sign signOf(X x) {
@@ -74,62 +79,72 @@ namespace {
 	}
 }
 
-BigInteger::BigInteger(long  x) : sign(signOf(x)), mag(magOf<long , unsigned long >(x)) {}
-BigInteger::BigInteger(int   x) : sign(signOf(x)), mag(magOf<int  , unsigned int  >(x)) {}
-BigInteger::BigInteger(short x) : sign(signOf(x)), mag(magOf<short, unsigned short>(x)) {}
+BigInteger::BigInteger(long long x) : sign(signOf(x)), mag(magOf<long long, unsigned long long>(x)) {}
+BigInteger::BigInteger(long      x) : sign(signOf(x)), mag(magOf<long     , unsigned long     >(x)) {}
+BigInteger::BigInteger(int       x) : sign(signOf(x)), mag(magOf<int      , unsigned int      >(x)) {}
+BigInteger::BigInteger(short     x) : sign(signOf(x)), mag(magOf<short    , unsigned short    >(x)) {}
+#ifdef __SIZEOF_INT128__
+BigInteger::BigInteger(BigUnsigned::Int128 x) : sign(signOf(x)), mag(magOf<BigUnsigned::Int128, BigUnsigned::UInt128>(x)) {}
+#endif
 
 // CONVERSION TO PRIMITIVE INTEGERS
 
-/* Reuse BigUnsigned's conversion to an unsigned primitive integer.
- * The friend is a separate function rather than
- * BigInteger::convertToUnsignedPrimitive to avoid requiring BigUnsigned to
- * declare BigInteger. */
+/* As in BigUnsigned, these compare the bit length of the magnitude with the
+ * value bits of X instead of converting and checking the round trip.  A
+ * signed X also holds -2^bits, whose magnitude is one bit longer. */
 template <class X>
-inline X convertBigUnsignedToPrimitiveAccess(const BigUnsigned &a) {
-	return a.convertToPrimitive<X>();
+bool BigInteger::fitsInPrimitive() const {
+	const bool isSigned = IfPrimitive<X, void>::isSigned;
+	const Index bits = 8 * sizeof(X) - isSigned;
+	Index l = mag.bitLength();
+	if (sign != negative)
+		return l <= bits;
+	else if (!isSigned)
+		return false;
+	else
+		return l <= bits || (l == bits + 1 && mag.countTrailingZeros() == bits);
 }
 
+/* The magnitude's low bits, negated in the widest unsigned type if
+ * necessary, convert to X with the right value once we know it fits. */
 template <class X>
-X BigInteger::convertToUnsignedPrimitive() const {
-	if (sign == negative)
+X BigInteger::convertToPrimitive() const {
+	if (!fitsInPrimitive<X>()) {
+		if (sign == negative && !IfPrimitive<X, void>::isSigned)
+			throw "BigInteger::to<Primitive>: "
+				"Cannot convert a negative integer to an unsigned type";
 		throw "BigInteger::to<Primitive>: "
-			"Cannot convert a negative integer to an unsigned type";
-	else
-		return convertBigUnsignedToPrimitiveAccess<X>(mag);
-}
-
-/* Similar to BigUnsigned::convertToPrimitive, but split into two cases for
- * nonnegative and negative numbers. */
-template <class X, class UX>
-X BigInteger::convertToSignedPrimitive() const {
-	if (sign == zero)
-		return 0;
-	else if (mag.getLength() == 1) {
-		// The single block might fit in an X.  Try the conversion.
-		Blk b = mag.getBlock(0);
-		if (sign == positive) {
-			X x = X(b);
-			if (x >= 0 && Blk(x) == b)
-				return x;
-		} else {
-			X x = -X(b);
-			/* UX(...) needed to avoid rejecting conversion of
-			 * -2^15 to a short. */
-			if (x < 0 && Blk(UX(-x)) == b)
-				return x;
-		}
-		// Otherwise fall through.
+			"Value is too big to fit in the requested type";
 	}
-	throw "BigInteger::to<Primitive>: "
-		"Value is too big to fit in the requested type";
+	BigUnsigned::WidestUnsigned w = mag.lowBits();
+	return X(sign == negative ? BigUnsigned::WidestUnsigned(0) - w : w);
 }
 
-unsigned long  BigInteger::toUnsignedLong () const { return convertToUnsignedPrimitive<unsigned long >       (); }
-unsigned int   BigInteger::toUnsignedInt  () const { return convertToUnsignedPrimitive<unsigned int  >       (); }
-unsigned short BigInteger::toUnsignedShort() const { return convertToUnsignedPrimitive<unsigned short>       (); }
-long           BigInteger::toLong         () const { return convertToSignedPrimitive  <long , unsigned long> (); }
-int            BigInteger::toInt          () const { return convertToSignedPrimitive  <int  , unsigned int>  (); }
-short          BigInteger::toShort        () const { return convertToSignedPrimitive  <short, unsigned short>(); }
+unsigned long long BigInteger::toUnsignedLongLong() const { return convertToPrimitive<unsigned long long>(); }
+long long          BigInteger::toLongLong        () const { return convertToPrimitive<         long long>(); }
+unsigned long      BigInteger::toUnsignedLong    () const { return convertToPrimitive<unsigned long     >(); }
+long               BigInteger::toLong            () const { return convertToPrimitive<         long     >(); }
+unsigned int       BigInteger::toUnsignedInt     () const { return convertToPrimitive<unsigned int      >(); }
+int                BigInteger::toInt             () const { return convertToPrimitive<         int      >(); }
+unsigned short     BigInteger::toUnsignedShort   () const { return convertToPrimitive<unsigned short    >(); }
+short              BigInteger::toShort           () const { return convertToPrimitive<         short    >(); }
+#ifdef __SIZEOF_INT128__
+BigUnsigned::UInt128 BigInteger::toUnsignedInt128() const { return convertToPrimitive<BigUnsigned::UInt128>(); }
+BigUnsigned:: Int128 BigInteger::toInt128        () const { return convertToPrimitive<BigUnsigned:: Int128>(); }
+#endif
+
+bool BigInteger::fitsInUnsignedLongLong() const { return fitsInPrimitive<unsigned long long>(); }
+bool BigInteger::fitsInLongLong        () const { return fitsInPrimitive<         long long>(); }
+bool BigInteger::fitsInUnsignedLong    () const { return fitsInPrimitive<unsigned long     >(); }
+bool BigInteger::fitsInLong            () const { return fitsInPrimitive<         long     >(); }
+bool BigInteger::fitsInUnsignedInt     () const { return fitsInPrimitive<unsigned int      >(); }
+bool BigInteger::fitsInInt             () const { return fitsInPrimitive<         int      >(); }
+bool BigInteger::fitsInUnsignedShort   () const { return fitsInPrimitive<unsigned short    >(); }
+bool BigInteger::fitsInShort           () const { return fitsInPrimitive<         short    >(); }
+#ifdef __SIZEOF_INT128__
+bool BigInteger::fitsInUnsignedInt128  () const { return fitsInPrimitive<BigUnsigned::UInt128>(); }
+bool BigInteger::fitsInInt128          () const { return fitsInPrimitive<BigUnsigned:: Int128>(); }
+#endif
 
 // COMPARISON
 BigInteger::CmpRes BigInteger::compareTo(const BigInteger &x) const {
@@ -255,6 +270,13 @@ void BigInteger::multiply(const BigInteger &a, const BigInteger &b) {
 	mag.multiply(a.mag, b.mag);
 }
 
+void BigInteger::pow(const BigInteger &a, unsigned long exponent) {
+	// Read a's sign first: a may be *this, and mag.pow handles that case.
+	Sign s = (a.sign == negative && (exponent & 1) != 0) ? negative : positive;
+	mag.pow(a.mag, exponent);
+	sign = mag.isZero() ? zero : s;
+}
+
 /*
  * DIVISION WITH REMAINDER
  * Please read the comments before the definition of
@@ -367,6 +389,201 @@ void BigInteger::negate(const BigInteger &a) {
 	sign = Sign(-a.sign);
 }
 
+// MIXED-TYPE OPERATIONS
+
+namespace {
+	BigInteger::Sign operandSign(const PrimitiveOperand &b) {
+		return b.isZero() ? BigInteger::zero
+			: b.negative ? BigInteger::negative : BigInteger::positive;
+	}
+	// For operands wider than a block
+	BigInteger operandValue(const PrimitiveOperand &b) {
+		return BigInteger(b.getMagnitude(), operandSign(b));
+	}
+}
+
+/* These read everything they need from a before writing *this, and the
+ * BigUnsigned operations they call work in place, so aliased calls need no
+ * temporary. */
+void BigInteger::addPrimitive(const BigInteger &a, const PrimitiveOperand &b) {
+	if (!b.fitsInBlock()) {
+		add(a, operandValue(b));
+		return;
+	}
+	Sign bSign = operandSign(b);
+	Blk m = b.getBlock();
+	if (bSign == zero)
+		operator =(a);
+	else if (a.sign == zero || a.sign == bSign) {
+		// Take b's sign and add the magnitudes.
+		sign = bSign;
+		mag.addBlock(a.mag, m);
+	} else switch (a.mag.compareToBlock(m)) {
+	case equal:
+		mag = 0;
+		sign = zero;
+		break;
+	case greater:
+		sign = a.sign;
+		mag.subtractBlock(a.mag, m);
+		break;
+	case less: {
+		// a's magnitude is a single block smaller than m.
+		Blk x = a.mag.getBlock(0);
+		sign = bSign;
+		mag = 0;
+		mag.addBlock(mag, m - x);
+		break;
+	}
+	}
+}
+
+void BigInteger::subtractPrimitive(const BigInteger &a,
+		const PrimitiveOperand &b) {
+	PrimitiveOperand negB(b);
+	negB.negative = !b.negative;
+	addPrimitive(a, negB);
+}
+
+void BigInteger::multiplyPrimitive(const BigInteger &a,
+		const PrimitiveOperand &b) {
+	if (!b.fitsInBlock()) {
+		multiply(a, operandValue(b));
+		return;
+	}
+	Sign bSign = operandSign(b);
+	if (a.sign == zero || bSign == zero) {
+		sign = zero;
+		mag = 0;
+		return;
+	}
+	sign = (a.sign == bSign) ? positive : negative;
+	mag.multiplyBlock(a.mag, b.getBlock());
+}
+
+/* With a single-block divisor m, the quotient and remainder come from
+ * BigUnsigned's short division of the magnitudes, corrected as in
+ * divideWithRemainder when the signs differ: the quotient moves one further
+ * from zero and the remainder r becomes m - r, unless r is 0. */
+void BigInteger::dividePrimitive(const BigInteger &a,
+		const PrimitiveOperand &b) {
+	if (!b.fitsInBlock()) {
+		BigInteger r(a);
+		r.divideWithRemainder(operandValue(b), *this);
+		return;
+	}
+	Sign bSign = operandSign(b);
+	if (a.sign == zero || bSign == zero) {
+		sign = zero;
+		mag = 0;
+		return;
+	}
+	bool sameSign = (a.sign == bSign);
+	Blk r = mag.divideBlock(a.mag, b.getBlock());
+	if (!sameSign && r != 0)
+		mag++;
+	sign = mag.isZero() ? zero : sameSign ? positive : negative;
+}
+
+void BigInteger::moduloPrimitive(const BigInteger &a,
+		const PrimitiveOperand &b) {
+	if (!b.fitsInBlock()) {
+		BigInteger q;
+		operator =(a);
+		divideWithRemainder(operandValue(b), q);
+		return;
+	}
+	Sign bSign = operandSign(b);
+	// As in divideWithRemainder, x % 0 == x.
+	if (bSign == zero) {
+		operator =(a);
+		return;
+	}
+	Blk m = b.getBlock();
+	Blk r = a.mag.remainderBlock(m);
+	if (a.sign != bSign && r != 0)
+		r = m - r;
+	// The remainder takes the sign of the divisor.
+	sign = (r == 0) ? zero : bSign;
+	mag = 0;
+	mag.setBlock(0, r);
+}
+
+BigInteger::CmpRes BigInteger::comparePrimitive(
+		const PrimitiveOperand &b) const {
+	Sign bSign = operandSign(b);
+	if (sign != bSign)
+		return (sign < bSign) ? less : greater;
+	CmpRes magCmp = b.fitsInBlock() ? mag.compareToBlock(b.getBlock())
+		: mag.compareTo(b.getMagnitude());
+	return (sign == negative) ? CmpRes(-magCmp) : magCmp;
+}
+
+// BITWISE OPERATORS
+
+/* The kernel reads the signs from its arguments before it writes anything,
+ * and it handles aliasing itself. */
+void BigInteger::bitAnd(const BigInteger &a, const BigInteger &b) {
+	bool neg = mag.bitwiseTwosComplement(a.mag, a.sign == negative,
+			b.mag, b.sign == negative, '&');
+	sign = mag.isZero() ? zero : neg ? negative : positive;
+}
+
+void BigInteger::bitOr(const BigInteger &a, const BigInteger &b) {
+	bool neg = mag.bitwiseTwosComplement(a.mag, a.sign == negative,
+			b.mag, b.sign == negative, '|');
+	sign = mag.isZero() ? zero : neg ? negative : positive;
+}
+
+void BigInteger::bitXor(const BigInteger &a, const BigInteger &b) {
+	bool neg = mag.bitwiseTwosComplement(a.mag, a.sign == negative,
+			b.mag, b.sign == negative, '^');
+	sign = mag.isZero() ? zero : neg ? negative : positive;
+}
+
+// ~a == -a - 1, which moves the magnitude one step away from or toward 0.
+void BigInteger::bitNot(const BigInteger &a) {
+	bool wasNegative = (a.sign == negative);
+	mag = a.mag;
+	if (wasNegative) {
+		mag--;
+		sign = mag.isZero() ? zero : positive;
+	} else {
+		mag++;
+		sign = negative;
+	}
+}
+
+void BigInteger::bitShiftLeft(const BigInteger &a, int b) {
+	if (b < 0) {
+		if (b == INT_MIN)
+			throw "BigInteger::bitShiftLeft: "
+				"Pathological shift amount not implemented";
+		bitShiftRight(a, -b);
+		return;
+	}
+	sign = a.sign;
+	mag.bitShiftLeft(a.mag, b);
+}
+
+/* Shifting the magnitude right rounds toward zero, so a negative number
+ * whose shifted-out bits are not all 0 needs one more step down. */
+void BigInteger::bitShiftRight(const BigInteger &a, int b) {
+	if (b < 0) {
+		if (b == INT_MIN)
+			throw "BigInteger::bitShiftRight: "
+				"Pathological shift amount not implemented";
+		bitShiftLeft(a, -b);
+		return;
+	}
+	Sign s = a.sign;
+	bool roundDown = (s == negative && a.mag.testAnyInRange(0, b));
+	mag.bitShiftRight(a.mag, b);
+	if (roundDown)
+		mag++;
+	sign = mag.isZero() ? zero : s;
+}
+
 // INCREMENT/DECREMENT OPERATORS
 
 // Prefix increment
@@ -54,26 +54,52 @@ public:
 	}
 
 	// Constructors from primitive integer types
-	BigInteger(unsigned long  x);
-	BigInteger(         long  x);
-	BigInteger(unsigned int   x);
-	BigInteger(         int   x);
-	BigInteger(unsigned short x);
-	BigInteger(         short x);
+	BigInteger(unsigned long long x);
+	BigInteger(         long long x);
+	BigInteger(unsigned long      x);
+	BigInteger(         long      x);
+	BigInteger(unsigned int       x);
+	BigInteger(         int       x);
+	BigInteger(unsigned short     x);
+	BigInteger(         short     x);
+#ifdef __SIZEOF_INT128__
+	BigInteger(BigUnsigned::UInt128 x);
+	BigInteger(BigUnsigned:: Int128 x);
+#endif
 
 	/* Converters to primitive integer types
 	 * The implicit conversion operators caused trouble, so these are now
-	 * named. */
-	unsigned long  toUnsignedLong () const;
-	long           toLong         () const;
-	unsigned int   toUnsignedInt  () const;
-	int            toInt          () const;
-	unsigned short toUnsignedShort() const;
-	short          toShort        () const;
+	 * named.  As in BigUnsigned, each has a fitsIn method that says
+	 * whether it would succeed. */
+	unsigned long long toUnsignedLongLong() const;
+	long long          toLongLong        () const;
+	unsigned long      toUnsignedLong    () const;
+	long               toLong            () const;
+	unsigned int       toUnsignedInt     () const;
+	int                toInt             () const;
+	unsigned short     toUnsignedShort   () const;
+	short              toShort           () const;
+#ifdef __SIZEOF_INT128__
+	BigUnsigned::UInt128 toUnsignedInt128() const;
+	BigUnsigned:: Int128 toInt128        () const;
+#endif
+
+	bool fitsInUnsignedLongLong() const;
+	bool fitsInLongLong        () const;
+	bool fitsInUnsignedLong    () const;
+	bool fitsInLong            () const;
+	bool fitsInUnsignedInt     () const;
+	bool fitsInInt             () const;
+	bool fitsInUnsignedShort   () const;
+	bool fitsInShort           () const;
+#ifdef __SIZEOF_INT128__
+	bool fitsInUnsignedInt128  () const;
+	bool fitsInInt128          () const;
+#endif
 protected:
-	// Helper
-	template <class X> X convertToUnsignedPrimitive() const;
-	template <class X, class UX> X convertToSignedPrimitive() const;
+	// Helpers
+	template <class X> bool fitsInPrimitive() const;
+	template <class X> X convertToPrimitive() const;
 public:
 
 	// ACCESSORS
@@ -103,18 +129,37 @@ public:
 	bool operator >=(const BigInteger &x) const { return compareTo(x) != less   ; }
 	bool operator > (const BigInteger &x) const { return compareTo(x) == greater; }
 
+	/* Returns a hash of the number; see BigUnsigned::hashValue.  A
+	 * nonnegative BigInteger hashes like its magnitude. */
+	Blk hashValue(Blk seed = 0) const {
+		return mag.hashValue(sign == negative ? ~seed : seed);
+	}
+
 	// OPERATORS -- See the discussion in BigUnsigned.hh.
 	void add     (const BigInteger &a, const BigInteger &b);
 	void subtract(const BigInteger &a, const BigInteger &b);
 	void multiply(const BigInteger &a, const BigInteger &b);
+	/* Sets *this to a ^ exponent; the result is negative when a is and the
+	 * exponent is odd.  See BigUnsigned::pow. */
+	void pow(const BigInteger &a, unsigned long exponent);
 	/* See the comment on BigUnsigned::divideWithRemainder.  Semantics
 	 * differ from those of primitive integers when negatives and/or zeros
 	 * are involved. */
 	void divideWithRemainder(const BigInteger &b, BigInteger &q);
 	void negate(const BigInteger &a);
-	
-	/* Bitwise operators are not provided for BigIntegers.  Use
-	 * getMagnitude to get the magnitude and operate on that instead. */
+
+	/* Bitwise operators act on the infinite two's complement
+	 * representation, as for Python's or GMP's integers: -1 is all 1 bits,
+	 * so ~x == -x - 1, and x >> b rounds toward minus infinity.  Negative
+	 * operands are complemented a block at a time as the operation runs,
+	 * never as a whole.  Negative shift amounts shift the other way, as
+	 * in BigUnsigned. */
+	void bitAnd(const BigInteger &a, const BigInteger &b);
+	void bitOr(const BigInteger &a, const BigInteger &b);
+	void bitXor(const BigInteger &a, const BigInteger &b);
+	void bitNot(const BigInteger &a);
+	void bitShiftLeft(const BigInteger &a, int b);
+	void bitShiftRight(const BigInteger &a, int b);
 
 	BigInteger operator +(const BigInteger &x) const;
 	BigInteger operator -(const BigInteger &x) const;
@@ -122,14 +167,58 @@ public:
 	BigInteger operator /(const BigInteger &x) const;
 	BigInteger operator %(const BigInteger &x) const;
 	BigInteger operator -() const;
+	BigInteger operator &(const BigInteger &x) const;
+	BigInteger operator |(const BigInteger &x) const;
+	BigInteger operator ^(const BigInteger &x) const;
+	BigInteger operator ~() const;
+	BigInteger operator <<(int b) const;
+	BigInteger operator >>(int b) const;
 
 	void operator +=(const BigInteger &x);
 	void operator -=(const BigInteger &x);
 	void operator *=(const BigInteger &x);
 	void operator /=(const BigInteger &x);
 	void operator %=(const BigInteger &x);
+	void operator &=(const BigInteger &x);
+	void operator |=(const BigInteger &x);
+	void operator ^=(const BigInteger &x);
+	void operator <<=(int b);
+	void operator >>=(int b);
 	void flipSign();
 
+	/* Mixed-type operators, as in BigUnsigned: a primitive operand that
+	 * fits in a block goes to BigUnsigned's single-block operations with
+	 * the sign handled here, so no temporary BigInteger is constructed.
+	 * Division follows divideWithRemainder. */
+	template <class X> typename IfPrimitive<X, BigInteger>::Type operator +(X x) const;
+	template <class X> typename IfPrimitive<X, BigInteger>::Type operator -(X x) const;
+	template <class X> typename IfPrimitive<X, BigInteger>::Type operator *(X x) const;
+	template <class X> typename IfPrimitive<X, BigInteger>::Type operator /(X x) const;
+	template <class X> typename IfPrimitive<X, BigInteger>::Type operator %(X x) const;
+
+	template <class X> typename IfPrimitive<X, bool>::Type operator ==(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator !=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator < (X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator <=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator >=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator > (X x) const;
+
+	template <class X> typename IfPrimitive<X, void>::Type operator +=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator -=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator *=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator /=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator %=(X x);
+
+protected:
+	// Helpers for the above; subtractPrimitive negates b and adds.
+	void addPrimitive     (const BigInteger &a, const PrimitiveOperand &b);
+	void subtractPrimitive(const BigInteger &a, const PrimitiveOperand &b);
+	void multiplyPrimitive(const BigInteger &a, const PrimitiveOperand &b);
+	void dividePrimitive  (const BigInteger &a, const PrimitiveOperand &b);
+	void moduloPrimitive  (const BigInteger &a, const PrimitiveOperand &b);
+	CmpRes comparePrimitive(const PrimitiveOperand &b) const;
+public:
+
 	// INCREMENT/DECREMENT OPERATORS
 	void operator ++(   );
 	void operator ++(int);
@@ -175,6 +264,36 @@ inline BigInteger BigInteger::operator -() const {
 	ans.negate(*this);
 	return ans;
 }
+inline BigInteger BigInteger::operator &(const BigInteger &x) const {
+	BigInteger ans;
+	ans.bitAnd(*this, x);
+	return ans;
+}
+inline BigInteger BigInteger::operator |(const BigInteger &x) const {
+	BigInteger ans;
+	ans.bitOr(*this, x);
+	return ans;
+}
+inline BigInteger BigInteger::operator ^(const BigInteger &x) const {
+	BigInteger ans;
+	ans.bitXor(*this, x);
+	return ans;
+}
+inline BigInteger BigInteger::operator ~() const {
+	BigInteger ans;
+	ans.bitNot(*this);
+	return ans;
+}
+inline BigInteger BigInteger::operator <<(int b) const {
+	BigInteger ans;
+	ans.bitShiftLeft(*this, b);
+	return ans;
+}
+inline BigInteger BigInteger::operator >>(int b) const {
+	BigInteger ans;
+	ans.bitShiftRight(*this, b);
+	return ans;
+}
 
 /*
  * ASSIGNMENT OPERATORS
@@ -207,9 +326,111 @@ inline void BigInteger::operator %=(const BigInteger &x) {
 	// Mods *this by x.  Don't care about quotient left in q.
 	divideWithRemainder(x, q);
 }
+inline void BigInteger::operator &=(const BigInteger &x) {
+	bitAnd(*this, x);
+}
+inline void BigInteger::operator |=(const BigInteger &x) {
+	bitOr(*this, x);
+}
+inline void BigInteger::operator ^=(const BigInteger &x) {
+	bitXor(*this, x);
+}
+inline void BigInteger::operator <<=(int b) {
+	bitShiftLeft(*this, b);
+}
+inline void BigInteger::operator >>=(int b) {
+	bitShiftRight(*this, b);
+}
 // This one is trivial
 inline void BigInteger::flipSign() {
 	sign = Sign(-sign);
 }
 
+// MIXED-TYPE OPERATORS
+
+template <class X>
+inline typename IfPrimitive<X, BigInteger>::Type BigInteger::operator +(X x) const {
+	BigInteger ans;
+	ans.addPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigInteger>::Type BigInteger::operator -(X x) const {
+	BigInteger ans;
+	ans.subtractPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigInteger>::Type BigInteger::operator *(X x) const {
+	BigInteger ans;
+	ans.multiplyPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigInteger>::Type BigInteger::operator /(X x) const {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigInteger::operator /: division by zero";
+	BigInteger ans;
+	ans.dividePrimitive(*this, y);
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigInteger>::Type BigInteger::operator %(X x) const {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigInteger::operator %: division by zero";
+	BigInteger ans;
+	ans.moduloPrimitive(*this, y);
+	return ans;
+}
+
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator ==(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == equal;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator !=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != equal;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator < (X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == less;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator <=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != greater;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator >=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != less;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigInteger::operator > (X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == greater;
+}
+
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigInteger::operator +=(X x) {
+	addPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigInteger::operator -=(X x) {
+	subtractPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigInteger::operator *=(X x) {
+	multiplyPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigInteger::operator /=(X x) {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigInteger::operator /=: division by zero";
+	dividePrimitive(*this, y);
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigInteger::operator %=(X x) {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigInteger::operator %=: division by zero";
+	moduloPrimitive(*this, y);
+}
+
 #endif
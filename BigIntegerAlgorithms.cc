@@ -1,22 +1,316 @@
 #include "BigIntegerAlgorithms.hh"
 
-BigUnsigned gcd(BigUnsigned a, BigUnsigned b) {
-	BigUnsigned trash;
-	// Neat in-place alternating technique.
-	for (;;) {
-		if (b.isZero())
-			return a;
-		a.divideWithRemainder(b, trash);
-		if (a.isZero())
+namespace {
+	typedef BigUnsigned::Blk Blk;
+	typedef BigUnsigned::Index Index;
+
+	// Binary GCD of two blocks: only shifts and subtractions.
+	Blk gcdBlocks(Blk a, Blk b) {
+		if (a == 0)
 			return b;
-		b.divideWithRemainder(a, trash);
+		if (b == 0)
+			return a;
+		// Factor out the common powers of 2.
+		unsigned int shift = BigUnsigned::blockTrailingZeros(a | b);
+		a >>= BigUnsigned::blockTrailingZeros(a);
+		// Now a is odd; keep subtracting the smaller odd number.
+		do {
+			b >>= BigUnsigned::blockTrailingZeros(b);
+			if (a > b) {
+				Blk t = a;
+				a = b;
+				b = t;
+			}
+			b -= a;
+		} while (b != 0);
+		return a << shift;
+	}
+
+	/* Sets r = x*a + y*b, where x and y are single-precision cofactors of
+	 * opposite signs (or zero) and the result is known to be nonnegative. */
+	void combine(BigUnsigned &r, long long x, const BigUnsigned &a,
+			long long y, const BigUnsigned &b) {
+		BigUnsigned s, t;
+		if (x >= 0 && y <= 0) {
+			s.multiplyBlock(a, Blk(x));
+			t.multiplyBlock(b, Blk(-y));
+		} else {
+			s.multiplyBlock(b, Blk(y));
+			t.multiplyBlock(a, Blk(-x));
+		}
+		r.subtract(s, t);
+	}
+
+	/* Runs Euclid's algorithm on the leading digits x and y of two numbers
+	 * (Knuth's Algorithm L, TAOCP 4.5.2) for as long as the quotients
+	 * provably agree with those of the full numbers, and returns the
+	 * number of steps taken.  On return, (A B; C D) is the product of the
+	 * steps: the full pair (u, v) becomes (A*u + B*v, C*u + D*v).  The
+	 * signs alternate, so A and D are >= 0 and B and C are <= 0 after an
+	 * even number of steps, and the other way around after an odd number. */
+	unsigned int lehmerSteps(long long x, long long y,
+			long long &A, long long &B, long long &C, long long &D) {
+		unsigned int steps = 0;
+		A = 1; B = 0; C = 0; D = 1;
+		while (y + C != 0 && y + D != 0) {
+			long long q = (x + A) / (y + C);
+			if (q != (x + B) / (y + D))
+				break;
+			long long t;
+			t = A - q * C; A = C; C = t;
+			t = B - q * D; B = D; D = t;
+			t = x - q * y; x = y; y = t;
+			steps++;
+		}
+		return steps;
+	}
+
+	/* The leading digits used by lehmerSteps have this many bits, which
+	 * leaves room for the sums above in a long long. */
+	const unsigned int lehmerBits = BigUnsigned::N - 2 < 62 ? BigUnsigned::N - 2 : 62;
+
+	/* A StepMatrix records a run of Euclidean steps.  If the steps take
+	 * (a, b) to (alpha, beta), then (a; b) == M (alpha; beta), where M is
+	 * the product of the matrices (q 1; 1 0) for the quotients q.  So the
+	 * entries are nonnegative and the determinant is (-1)^steps. */
+	class StepMatrix {
+	public:
+		BigUnsigned m00, m01, m10, m11;
+		// Whether the determinant is -1
+		bool odd;
+
+		// Constructs the identity (no steps).
+		StepMatrix() : m00(1), m01(0), m10(0), m11(1), odd(false) {}
+
+		// Appends a step with quotient q: M = M (q 1; 1 0).
+		void appendQuotient(const BigUnsigned &q) {
+			BigUnsigned t;
+			t.multiply(m00, q);
+			t += m01;
+			m01 = m00;
+			m00 = t;
+			t.multiply(m10, q);
+			t += m11;
+			m11 = m10;
+			m10 = t;
+			odd = !odd;
+		}
+
+		/* Appends the steps found by lehmerSteps.  Their matrix is the
+		 * inverse of (A B; C D), namely (|D| |B|; |C| |A|). */
+		void appendLehmer(long long A, long long B, long long C, long long D,
+				unsigned int steps) {
+			Blk p = Blk(D < 0 ? -D : D), q = Blk(B < 0 ? -B : B),
+				r = Blk(C < 0 ? -C : C), u = Blk(A < 0 ? -A : A);
+			BigUnsigned s, t, x;
+			// (m00 m01) = (m00 p + m01 r, m00 q + m01 u)
+			s.multiplyBlock(m00, p); t.multiplyBlock(m01, r); x.add(s, t);
+			s.multiplyBlock(m00, q); t.multiplyBlock(m01, u); m01.add(s, t);
+			m00 = x;
+			// Likewise for (m10 m11).
+			s.multiplyBlock(m10, p); t.multiplyBlock(m11, r); x.add(s, t);
+			s.multiplyBlock(m10, q); t.multiplyBlock(m11, u); m11.add(s, t);
+			m10 = x;
+			odd = (odd != (steps % 2 == 1));
+		}
+
+		// Appends the steps recorded in another StepMatrix: M = M N.
+		void append(const StepMatrix &n) {
+			BigUnsigned s, t, x;
+			s.multiply(m00, n.m00); t.multiply(m01, n.m10); x.add(s, t);
+			s.multiply(m00, n.m01); t.multiply(m01, n.m11); m01.add(s, t);
+			m00 = x;
+			s.multiply(m10, n.m00); t.multiply(m11, n.m10); x.add(s, t);
+			s.multiply(m10, n.m01); t.multiply(m11, n.m11); m11.add(s, t);
+			m10 = x;
+			odd = (odd != n.odd);
+		}
+	};
+
+	// One Euclidean step: (a, b) = (b, a % b).
+	void euclidStep(BigUnsigned &a, BigUnsigned &b, StepMatrix *m) {
+		BigUnsigned q;
+		a.divideWithRemainder(b, q);
+		if (m != NULL)
+			m->appendQuotient(q);
+		q = a;
+		a = b;
+		b = q;
+	}
+
+	/* One round of Lehmer's algorithm on (a, b), where a >= b and b is at
+	 * least two blocks long: most Euclidean steps are decided by the
+	 * leading digits alone, so we run them in single precision and apply
+	 * the accumulated cofactors to the full numbers with four block
+	 * multiplications.  When the leading digits can't decide a quotient
+	 * (typically because it is huge), we take a full division step. */
+	void lehmerRound(BigUnsigned &a, BigUnsigned &b, StepMatrix *m) {
+		Index shift = a.bitLength() - lehmerBits;
+		long long A, B, C, D;
+		unsigned int steps = lehmerSteps(
+			(long long)(a.getBits(shift, BigUnsigned::N)),
+			(long long)(b.getBits(shift, BigUnsigned::N)), A, B, C, D);
+		if (steps == 0) {
+			euclidStep(a, b, m);
+			return;
+		}
+		BigUnsigned t;
+		combine(t, A, a, B, b);
+		combine(b, C, a, D, b);
+		a = t;
+		if (m != NULL)
+			m->appendLehmer(A, B, C, D, steps);
+	}
+
+	/* If (alpha; beta) = M^-1 (a; b) satisfies alpha > beta >= 0, sets
+	 * (a, b) to it and returns true.  Otherwise leaves a and b alone and
+	 * returns false.  Since M^-1 = +-(m11 -m01; -m10 m00), it is enough to
+	 * check the signs. */
+	bool applyInverse(const StepMatrix &m, BigUnsigned &a, BigUnsigned &b) {
+		BigUnsigned x, y, alpha, beta;
+		x.multiply(m.m11, a);
+		y.multiply(m.m01, b);
+		if (m.odd ? (y < x) : (x < y))
+			return false;
+		if (m.odd)
+			alpha.subtract(y, x);
+		else
+			alpha.subtract(x, y);
+		x.multiply(m.m00, b);
+		y.multiply(m.m10, a);
+		if (m.odd ? (y < x) : (x < y))
+			return false;
+		if (m.odd)
+			beta.subtract(y, x);
+		else
+			beta.subtract(x, y);
+		if (alpha <= beta)
+			return false;
+		a = alpha;
+		b = beta;
+		return true;
 	}
+
+	// Below this many blocks, the half-gcd recursion doesn't pay.
+	const Index hgcdThreshold = 100;
+
+	/* Half-gcd: takes Euclidean steps on (a, b), where a > b, until b is
+	 * at most s = a.getLength() / 2 + 1 blocks long, and appends them to
+	 * *m if m is not NULL.
+	 *
+	 * Above hgcdThreshold, most of the steps are found recursively, in the
+	 * manner of Schoenhage and Thull-Yap: the steps Euclid's algorithm
+	 * takes on the top halves of a and b are, all but the last few, the
+	 * steps it takes on a and b themselves.  So a recursive call on the
+	 * top halves shrinks (a, b) by a quarter, one division step deals with
+	 * a possibly large quotient, and a second recursive call on the top
+	 * halves of what remains brings b down to about s blocks.  Each
+	 * recursive result is checked by applyInverse before we use it, since
+	 * "all but the last few" is not "all".  Lehmer rounds finish up, so
+	 * the work is O(M(n) log n), where M(n) is the cost of multiplying two
+	 * n-block numbers. */
+	void halfGcd(BigUnsigned &a, BigUnsigned &b, StepMatrix *m) {
+		Index n = a.getLength(), s = n / 2 + 1;
+		if (b.getLength() <= s)
+			return;
+		if (n >= hgcdThreshold) {
+			// Work on the top n - n/2 blocks.
+			Index p = n / 2;
+			BigUnsigned a1, b1;
+			a1.bitShiftRight(a, p * BigUnsigned::N);
+			b1.bitShiftRight(b, p * BigUnsigned::N);
+			if (b1 < a1) {
+				StepMatrix m1;
+				halfGcd(a1, b1, &m1);
+				if (applyInverse(m1, a, b) && m != NULL)
+					m->append(m1);
+			}
+			if (b.getLength() <= s)
+				return;
+			euclidStep(a, b, m);
+			if (b.getLength() <= s)
+				return;
+			/* Now a has l < n blocks.  Reducing the top 2(l - s) blocks
+			 * by half should leave b with about s blocks. */
+			p = 2 * s - a.getLength();
+			a1.bitShiftRight(a, p * BigUnsigned::N);
+			b1.bitShiftRight(b, p * BigUnsigned::N);
+			if (b1 < a1) {
+				StepMatrix m2;
+				halfGcd(a1, b1, &m2);
+				if (applyInverse(m2, a, b) && m != NULL)
+					m->append(m2);
+			}
+		}
+		while (b.getLength() > s)
+			lehmerRound(a, b, m);
+	}
+}
+
+/* Lehmer's algorithm (see lehmerRound), with the half-gcd recursion for
+ * large numbers (see halfGcd).  Once the smaller number fits in a block,
+ * binary GCD finishes the job. */
+BigUnsigned gcd(BigUnsigned a, BigUnsigned b) {
+	if (a < b) {
+		BigUnsigned t(a);
+		a = b;
+		b = t;
+	}
+	// Invariant: a >= b.
+	while (b.getLength() > 1) {
+		if (b.getLength() >= hgcdThreshold) {
+			halfGcd(a, b, NULL);
+			// halfGcd does nothing if b is much shorter than a.
+			if (!b.isZero())
+				euclidStep(a, b, NULL);
+		} else
+			lehmerRound(a, b, NULL);
+	}
+	if (b.isZero())
+		return a;
+	BigUnsigned trash;
+	a.divideWithRemainder(b, trash);
+	return BigUnsigned(gcdBlocks(a.getBlock(0), b.getBlock(0)));
 }
 
 void extendedEuclidean(BigInteger m, BigInteger n,
 		BigInteger &g, BigInteger &r, BigInteger &s) {
 	if (&g == &r || &g == &s || &r == &s)
 		throw "BigInteger extendedEuclidean: Outputs are aliased";
+	if (m.getSign() != BigInteger::negative
+			&& n.getSign() != BigInteger::negative) {
+		/* For nonnegative inputs, find the same steps that the loop below
+		 * would take, but with Lehmer's algorithm and the half-gcd
+		 * recursion, keeping track of them in a StepMatrix.  The loop
+		 * first swaps m and n if m < n; do the same. */
+		bool swapped = m < n;
+		BigUnsigned a(swapped ? n.getMagnitude() : m.getMagnitude()),
+			b(swapped ? m.getMagnitude() : n.getMagnitude());
+		StepMatrix steps;
+		while (!b.isZero()) {
+			if (b.getLength() >= hgcdThreshold) {
+				StepMatrix h;
+				halfGcd(a, b, &h);
+				steps.append(h);
+				if (!b.isZero())
+					euclidStep(a, b, &steps);
+			} else if (b.getLength() > 1)
+				lehmerRound(a, b, &steps);
+			else
+				euclidStep(a, b, &steps);
+		}
+		/* Now (a; 0) == M^-1 (a0; b0) with M^-1 = +-(m11 -m01; -m10 m00),
+		 * so a == +-(m11 a0 - m01 b0). */
+		BigInteger x(steps.m11), y(steps.m01);
+		if (steps.odd)
+			x.flipSign();
+		else
+			y.flipSign();
+		g = a;
+		r = swapped ? y : x;
+		s = swapped ? x : y;
+		return;
+	}
 	BigInteger r1(1), s1(0), r2(0), s2(1), q;
 	/* Invariants:
 	 * r1*m(orig) + s1*n(orig) == m(current)
@@ -40,30 +334,1419 @@ void extendedEuclidean(BigInteger m, BigInteger n,
 	}
 }
 
+namespace {
+	/* One Euclidean step (u, v) = (v, u - q*v) for modinv, with the
+	 * matching update of the cofactor magnitudes: the new tv is tu + q*tv
+	 * because the two cofactors have opposite signs. */
+	void cofactorStep(BigUnsigned &u, BigUnsigned &v,
+			BigUnsigned &tu, BigUnsigned &tv) {
+		BigUnsigned q, t;
+		u.divideWithRemainder(v, q);
+		t.multiply(q, tv);
+		t += tu;
+		tu = tv;
+		tv = t;
+		t = u;
+		u = v;
+		v = t;
+	}
+}
+
+/* Euclid's algorithm on (u, v) = (n, x % n), keeping track of only the
+ * cofactor of x: u == tu * x and v == tv * x (mod n).  The cofactors
+ * alternate in sign, so we keep their magnitudes as BigUnsigneds and
+ * remember which one is negative.  Most steps are Lehmer steps, which
+ * update the cofactors with four block multiplications, and the last
+ * few are done in single precision. */
 BigUnsigned modinv(const BigInteger &x, const BigUnsigned &n) {
-	BigInteger g, r, s;
-	extendedEuclidean(x, n, g, r, s);
-	if (g == 1)
-		// r*x + s*n == 1, so r*x === 1 (mod n), so r is the answer.
-		return (r % n).getMagnitude(); // (r % n) will be nonnegative
-	else
+	BigUnsigned u(n), v((x % n).getMagnitude()), tu(0), tv(1), s, t;
+	// Whether tu is the negative cofactor (tu == 0 counts as negative)
+	bool tuNegative = true;
+	while (v.getLength() > 1) {
+		Index shift = u.bitLength() - lehmerBits;
+		long long A, B, C, D;
+		unsigned int steps = lehmerSteps(
+			(long long)(u.getBits(shift, BigUnsigned::N)),
+			(long long)(v.getBits(shift, BigUnsigned::N)), A, B, C, D);
+		if (steps == 0) {
+			cofactorStep(u, v, tu, tv);
+			tuNegative = !tuNegative;
+			continue;
+		}
+		combine(t, A, u, B, v);
+		combine(v, C, u, D, v);
+		u = t;
+		// A*tu and B*tv have the same sign, and so do C*tu and D*tv.
+		BigUnsigned tu2;
+		s.multiplyBlock(tu, Blk(A < 0 ? -A : A));
+		t.multiplyBlock(tv, Blk(B < 0 ? -B : B));
+		tu2.add(s, t);
+		s.multiplyBlock(tu, Blk(C < 0 ? -C : C));
+		t.multiplyBlock(tv, Blk(D < 0 ? -D : D));
+		tv.add(s, t);
+		tu = tu2;
+		if (steps % 2 == 1)
+			tuNegative = !tuNegative;
+	}
+	// Now v fits in a block, and one more step brings u down to a block.
+	if (!v.isZero()) {
+		cofactorStep(u, v, tu, tv);
+		tuNegative = !tuNegative;
+	}
+	if (u.getLength() > 1)
 		throw "BigInteger modinv: x and n have a common factor";
+	Blk ub = u.getBlock(0), vb = v.getBlock(0);
+	while (vb != 0) {
+		Blk q = ub / vb, r = ub % vb;
+		t.multiplyBlock(tv, q);
+		t += tu;
+		tu = tv;
+		tv = t;
+		ub = vb;
+		vb = r;
+		tuNegative = !tuNegative;
+	}
+	if (ub != 1)
+		throw "BigInteger modinv: x and n have a common factor";
+	if (tuNegative && !tu.isZero())
+		tu.subtract(n, tu);
+	return tu;
+}
+
+void batchModinv(const BigInteger *values, BigUnsigned::Index count,
+		const BigUnsigned &modulus, BigUnsigned *inverses) {
+	if (count == 0)
+		return;
+	BarrettReducer reducer(modulus);
+	BigUnsigned *reduced = new BigUnsigned[count];
+	try {
+		BigUnsigned temp;
+		// Set inverses[i] to the product of the first i + 1 values.
+		for (Index i = 0; i < count; i++) {
+			reduced[i] = (values[i] % modulus).getMagnitude();
+			if (i == 0)
+				inverses[i] = reduced[i];
+			else {
+				temp.multiply(inverses[i - 1], reduced[i]);
+				inverses[i] = reducer.reduce(temp);
+			}
+		}
+		// Invert the whole product, then peel off one value at a time.
+		BigUnsigned inv = modinv(inverses[count - 1], modulus);
+		for (Index i = count - 1; i > 0; i--) {
+			// inv is the inverse of the product of the first i + 1 values.
+			temp.multiply(inv, inverses[i - 1]);
+			inverses[i] = reducer.reduce(temp);
+			temp.multiply(inv, reduced[i]);
+			inv = reducer.reduce(temp);
+		}
+		inverses[0] = inv;
+	} catch (...) {
+		delete [] reduced;
+		throw;
+	}
+	delete [] reduced;
+}
+
+namespace {
+	/* Returns (base ^ exponent) % m for base < m, where m is the modulus of
+	 * the given reducer.  Callers that exponentiate many times modulo the
+	 * same m share one reducer this way. */
+	BigUnsigned modexpReduced(const BigUnsigned &base,
+			const BigUnsigned &exponent, const BarrettReducer &reducer) {
+		BigUnsigned ans = 1, temp;
+		BigUnsigned::Index i = exponent.bitLength();
+		// For each bit of the exponent, most to least significant...
+		while (i > 0) {
+			i--;
+			// Square.
+			temp.multiply(ans, ans);
+			ans = reducer.reduce(temp);
+			// And multiply if the bit is a 1.
+			if (exponent.getBit(i)) {
+				temp.multiply(ans, base);
+				ans = reducer.reduce(temp);
+			}
+		}
+		return ans;
+	}
 }
 
 BigUnsigned modexp(const BigInteger &base, const BigUnsigned &exponent,
 		const BigUnsigned &modulus) {
-	BigUnsigned ans = 1, base2 = (base % modulus).getMagnitude();
-	BigUnsigned::Index i = exponent.bitLength();
-	// For each bit of the exponent, most to least significant...
+	// Every reduction is by the same modulus, so pay for one division only.
+	BarrettReducer reducer(modulus);
+	return modexpReduced((base % modulus).getMagnitude(), exponent, reducer);
+}
+
+namespace {
+	/* Chooses the width in bits of the exponent windows for an exponent of
+	 * the given bit length, balancing the cost of the table of powers
+	 * (2^w entries) against the number of window multiplications (bits/w). */
+	unsigned int windowBits(BigUnsigned::Index bits) {
+		return (bits <= 24) ? 1
+			: (bits <= 80) ? 3
+			: (bits <= 240) ? 4
+			: (bits <= 672) ? 5
+			: 6;
+	}
+
+}
+
+/* Straus's interleaved method with fixed windows: each base gets a table of
+ * its first 2^w powers, and the exponents are scanned together w bits at a
+ * time from the top.  A single run of w squarings then serves every base. */
+BigUnsigned multiExp(const BigInteger *bases, const BigUnsigned *exponents,
+		BigUnsigned::Index count, const BigUnsigned &modulus) {
+	BarrettReducer reducer(modulus);
+	BigUnsigned::Index i, maxBits = 0;
+	for (i = 0; i < count; i++)
+		if (exponents[i].bitLength() > maxBits)
+			maxBits = exponents[i].bitLength();
+	unsigned int w = windowBits(maxBits);
+	unsigned int tableSize = 1U << w;
+
+	// table[(i << w) + d] == bases[i] ^ d % modulus
+	BigUnsigned *table = new BigUnsigned[count << w];
+	BigUnsigned temp;
+	for (i = 0; i < count; i++) {
+		BigUnsigned *t = table + (i << w);
+		t[0] = 1;
+		t[1] = (bases[i] % modulus).getMagnitude();
+		for (unsigned int d = 2; d < tableSize; d++) {
+			temp.multiply(t[d - 1], t[1]);
+			t[d] = reducer.reduce(temp);
+		}
+	}
+
+	BigUnsigned ans = 1;
+	bool started = false;
+	BigUnsigned::Index pos = (maxBits + w - 1) / w * w;
+	// For each window of the exponents, most to least significant...
+	while (pos > 0) {
+		pos -= w;
+		// Square w times, unless ans is still 1.
+		if (started)
+			for (unsigned int j = 0; j < w; j++) {
+				temp.multiply(ans, ans);
+				ans = reducer.reduce(temp);
+			}
+		// And multiply in each base's window.
+		for (i = 0; i < count; i++) {
+			unsigned int d = (unsigned int)(exponents[i].getBits(pos, w));
+			if (d != 0) {
+				temp.multiply(ans, table[(i << w) + d]);
+				ans = reducer.reduce(temp);
+				started = true;
+			}
+		}
+	}
+	delete [] table;
+	return ans;
+}
+
+BigUnsigned isqrt(const BigUnsigned &x) {
+	if (x.isZero())
+		return BigUnsigned();
+	/* Newton's iteration y = (y + x/y) / 2, started from a power of 2 no
+	 * smaller than the root, decreases until it reaches the root. */
+	BigUnsigned y(1), z, q;
+	y <<= (x.bitLength() + 1) / 2;
+	for (;;) {
+		z = x;
+		z.divideWithRemainder(y, q);
+		q += y;
+		q >>= 1;
+		if (!(q < y))
+			return y;
+		y = q;
+	}
+}
+
+void isqrtRem(const BigUnsigned &x, BigUnsigned &s, BigUnsigned &r) {
+	if (&s == &r)
+		throw "BigInteger isqrtRem: Outputs are aliased";
+	BigUnsigned root = isqrt(x), square;
+	square.multiply(root, root);
+	r.subtract(x, square);
+	s = root;
+}
+
+BigUnsigned iroot(const BigUnsigned &x, unsigned int k) {
+	if (k == 0)
+		throw "BigInteger iroot: k must be positive";
+	if (k == 1 || x.isZero())
+		return x;
+	// If x < 2^k, the root is 1.
+	BigUnsigned::Index bits = x.bitLength();
+	if (bits <= k)
+		return BigUnsigned(1);
+	/* As in isqrt, the iteration y = ((k-1)*y + x/y^(k-1)) / k decreases
+	 * from a power of 2 no smaller than the root until it reaches it. */
+	BigUnsigned y(1), z, q, t;
+	y <<= (bits + k - 1) / k;
+	for (;;) {
+		z = x;
+		t.pow(y, k - 1);
+		z.divideWithRemainder(t, q);
+		t.multiplyBlock(y, k - 1);
+		q += t;
+		z = q;
+		z.divideWithRemainder(BigUnsigned(k), q);
+		if (!(q < y))
+			return y;
+		y = q;
+	}
+}
+
+namespace {
+	/* Returns x % d for d < 2^32, working through x a half-block at a time
+	 * so that the running remainder never overflows a long long. */
+	unsigned long remainderSmall(const BigUnsigned &x, unsigned long d) {
+		const unsigned int h = BigUnsigned::N / 2;
+		const Blk lowMask = (Blk(1) << h) - 1;
+		unsigned long long r = 0;
+		Index i = x.getLength();
+		while (i > 0) {
+			i--;
+			Blk b = x.getBlock(i);
+			r = ((r << h) | (b >> h)) % d;
+			r = ((r << h) | (b & lowMask)) % d;
+		}
+		return (unsigned long)(r);
+	}
+
+	/* Bit r of mask is set if r is a square modulo m.  The moduli are
+	 * coprime, and a number that passes all of them (and the test modulo
+	 * 64) is a square with probability about 1/600. */
+	struct SquareFilter {
+		unsigned int m;
+		unsigned long long mask;
+	};
+	const SquareFilter squareFilters[] = {
+		{ 63, 0x402483012450293ULL },
+		{ 25, 0x1294a53ULL },
+		{ 11, 0x23bULL },
+		{ 13, 0x161bULL },
+		{ 17, 0x1a317ULL },
+		{ 19, 0x30af3ULL },
+		{ 23, 0x5335fULL },
+	};
+	// The product of the moduli above
+	const unsigned long squareFilterProduct = 1673196525UL;
+	// Bit r is set if r is a square modulo 64.
+	const unsigned long long squaresMod64 = 0x202021202030213ULL;
+
+	// Returns b^e % m for small m.
+	unsigned long modexpSmall(unsigned long b, unsigned long e, unsigned long m) {
+		unsigned long long ans = 1, x = b % m;
+		for (; e != 0; e >>= 1) {
+			if ((e & 1) != 0)
+				ans = ans * x % m;
+			x = x * x % m;
+		}
+		return (unsigned long)(ans);
+	}
+
+	bool isSmallPrime(unsigned long p) {
+		if (p < 2)
+			return false;
+		for (unsigned long d = 2; d <= p / d; d++)
+			if (p % d == 0)
+				return false;
+		return true;
+	}
+
+	/* Returns true unless x is provably not a p-th power for the odd prime
+	 * p: a p-th power is a p-th power residue modulo each prime q == 1
+	 * (mod p), and only about 1 in p residues are.  Tries the first few
+	 * such q below 2^32. */
+	bool mayBePower(const BigUnsigned &x, unsigned long p) {
+		unsigned int tried = 0;
+		for (unsigned long long q = 2 * p + 1; tried < 4 && q < 0x100000000ULL;
+				q += 2 * p) {
+			if (!isSmallPrime((unsigned long)(q)))
+				continue;
+			tried++;
+			unsigned long r = remainderSmall(x, (unsigned long)(q));
+			if (r != 0 && modexpSmall(r, (unsigned long)((q - 1) / p),
+					(unsigned long)(q)) != 1)
+				return false;
+		}
+		return true;
+	}
+}
+
+bool isPerfectSquare(const BigUnsigned &x) {
+	if (((squaresMod64 >> (x.getBlock(0) & 63)) & 1) == 0)
+		return false;
+	// One pass over x gives its residue modulo all the filter moduli.
+	unsigned long r = remainderSmall(x, squareFilterProduct);
+	for (unsigned int i = 0; i < sizeof(squareFilters) / sizeof(squareFilters[0]); i++)
+		if (((squareFilters[i].mask >> (r % squareFilters[i].m)) & 1) == 0)
+			return false;
+	BigUnsigned s, rem;
+	isqrtRem(x, s, rem);
+	return rem.isZero();
+}
+
+unsigned int perfectPowerExponent(const BigUnsigned &x) {
+	if (x < 2)
+		return 0;
+	/* If x == y^k with k as large as possible, then x is a p-th power for
+	 * exactly the primes p dividing k.  So find the smallest such p, take
+	 * the p-th root y, and recurse: k = p * perfectPowerExponent(y). */
+	Index bits = x.bitLength(), zeros = x.countTrailingZeros();
+	for (unsigned long p = 2; p < bits; p++) {
+		if (!isSmallPrime(p))
+			continue;
+		// The power of 2 dividing x must be a p-th power too.
+		if (zeros % p != 0)
+			continue;
+		BigUnsigned y;
+		if (p == 2) {
+			if (!isPerfectSquare(x))
+				continue;
+			y = isqrt(x);
+		} else {
+			if (!mayBePower(x, p))
+				continue;
+			y = iroot(x, (unsigned int)(p));
+			BigUnsigned check;
+			check.pow(y, p);
+			if (check != x)
+				continue;
+		}
+		return (unsigned int)(p) * perfectPowerExponent(y);
+	}
+	return 1;
+}
+
+namespace {
+	/* The Jacobi symbol (a/n) for odd n, by the binary algorithm: factors
+	 * of 2 come out of a by the second supplementary law, and otherwise
+	 * the larger of a and n is reduced by subtracting the smaller, with
+	 * reciprocity whenever they swap roles.  The shifts and subtractions go
+	 * through a scratch number that is swapped in, and once n fits in a
+	 * block the rest is done on machine words. */
+	int jacobiSymbol(BigUnsigned a, BigUnsigned n) {
+		int t = 1;
+		BigUnsigned temp;
+		if (a.getLength() > n.getLength())
+			a.divideWithRemainder(n, temp);
+		while (n.getLength() > 1) {
+			if (a.isZero())
+				return 0;
+			Index z = a.countTrailingZeros();
+			if (z != 0) {
+				temp.bitShiftRight(a, z);
+				a.swap(temp);
+			}
+			Blk n8 = n.getBlock(0) & 7;
+			if (z % 2 == 1 && (n8 == 3 || n8 == 5))
+				t = -t;
+			if (a < n) {
+				a.swap(n);
+				if ((a.getBlock(0) & 3) == 3 && (n.getBlock(0) & 3) == 3)
+					t = -t;
+			}
+			temp.subtract(a, n);
+			a.swap(temp);
+		}
+		if (a.getLength() > 1)
+			a.divideWithRemainder(n, temp);
+		Blk x = a.getBlock(0), y = n.getBlock(0);
+		while (x != 0) {
+			unsigned int zx = BigUnsigned::blockTrailingZeros(x);
+			x >>= zx;
+			if (zx % 2 == 1 && ((y & 7) == 3 || (y & 7) == 5))
+				t = -t;
+			if (x < y) {
+				Blk w = x;
+				x = y;
+				y = w;
+				if ((x & 3) == 3 && (y & 3) == 3)
+					t = -t;
+			}
+			x -= y;
+		}
+		return (y == 1) ? t : 0;
+	}
+
+	// Trial division is by the odd primes below this bound.
+	const unsigned long trialDivisionBound = 1000;
+
+	/* Returns -1 if n has an odd prime factor p < trialDivisionBound other
+	 * than n itself, 1 if n is such a prime or has no small factor and is
+	 * below trialDivisionBound^2 (so it is prime), and 0 otherwise.  The
+	 * primes are taken in groups whose products fit in 32 bits, so each
+	 * group costs a single pass of single-block remainders over n. */
+	int trialDivision(const BigUnsigned &n) {
+		unsigned long group[8], product = 1;
+		unsigned int count = 0;
+		for (unsigned long p = 3; p < trialDivisionBound + 2; p += 2) {
+			bool flush = (p >= trialDivisionBound);
+			if (!flush && !isSmallPrime(p))
+				continue;
+			if (flush || product > 0xffffffffUL / p || count == 8) {
+				unsigned long r = remainderSmall(n, product);
+				for (unsigned int i = 0; i < count; i++)
+					if (r % group[i] == 0)
+						return (n == group[i]) ? 1 : -1;
+				product = 1;
+				count = 0;
+				if (flush)
+					break;
+			}
+			group[count++] = p;
+			product *= p;
+		}
+		return (n < BigUnsigned(trialDivisionBound * trialDivisionBound)) ? 1 : 0;
+	}
+
+	// Returns (a - b) mod m for a, b < m.
+	BigUnsigned subtractMod(const BigUnsigned &a, const BigUnsigned &b,
+			const BigUnsigned &m) {
+		BigUnsigned r(a);
+		if (r < b)
+			r += m;
+		r -= b;
+		return r;
+	}
+
+	// Returns x / 2 mod m for x < m, with m odd.
+	BigUnsigned halveMod(const BigUnsigned &x, const BigUnsigned &m) {
+		BigUnsigned r(x);
+		if (r.getBit(0))
+			r += m;
+		r >>= 1;
+		return r;
+	}
+
+	/* Strong probable prime test to base a, for odd n > a + 1, where
+	 * n - 1 == d * 2^s with d odd. */
+	bool millerRabin(const BigUnsigned &n, const BigUnsigned &a,
+			const BigUnsigned &d, Index s, const BarrettReducer &reducer) {
+		BigUnsigned nMinus1(n), temp;
+		nMinus1 -= 1;
+		BigUnsigned x = modexpReduced(a, d, reducer);
+		if (x == 1 || x == nMinus1)
+			return true;
+		for (Index r = 1; r < s; r++) {
+			temp.multiply(x, x);
+			x = reducer.reduce(temp);
+			if (x == nMinus1)
+				return true;
+			if (x == 1)
+				return false;
+		}
+		return false;
+	}
+
+	/* Strong Lucas probable prime test with Selfridge's parameters: D is
+	 * the first of 5, -7, 9, -11, ... with (D/n) == -1, P == 1 and
+	 * Q == (1 - D) / 4.  With n + 1 == d * 2^s, n passes if U_d == 0 or
+	 * V_(d*2^r) == 0 for some r < s.  n must be odd, not a square, and
+	 * bigger than any D we try. */
+	bool strongLucas(const BigUnsigned &n, const BarrettReducer &reducer) {
+		// Find D, keeping its absolute value and sign.
+		unsigned long absD = 5;
+		bool negativeD = false;
+		for (;;) {
+			BigUnsigned dMod(absD);
+			if (negativeD)
+				dMod.subtract(n, dMod);
+			int j = jacobiSymbol(dMod, n);
+			if (j == -1)
+				break;
+			if (j == 0)
+				// absD shares a factor with n, and n is bigger than absD.
+				return false;
+			absD += 2;
+			negativeD = !negativeD;
+		}
+		/* Work modulo n throughout: D and Q == (1 - D) / 4, which is
+		 * (1 + |D|) / 4 when D < 0 and -((|D| - 1) / 4) otherwise. */
+		BigUnsigned dMod(absD), q(negativeD ? (absD + 1) / 4 : (absD - 1) / 4);
+		if (negativeD)
+			dMod.subtract(n, dMod);
+		if (!negativeD && !q.isZero())
+			q.subtract(n, q);
+		// n + 1 == d * 2^s
+		BigUnsigned d(n);
+		d += 1;
+		Index s = d.countTrailingZeros();
+		d >>= s;
+		/* Run through the bits of d, keeping (U_k, V_k, Q^k) and using
+		 *    U_2k = U_k V_k,                 V_2k = V_k^2 - 2 Q^k,
+		 *    U_(k+1) = (U_k + V_k) / 2,      V_(k+1) = (D U_k + V_k) / 2. */
+		BigUnsigned u(1), v(1), qk(q), temp, t2;
+		Index i = d.bitLength() - 1;
+		while (i > 0) {
+			i--;
+			temp.multiply(u, v);
+			u = reducer.reduce(temp);
+			temp.multiply(v, v);
+			t2 = qk;
+			t2 <<= 1;
+			v = subtractMod(reducer.reduce(temp), reducer.reduce(t2), n);
+			temp.multiply(qk, qk);
+			qk = reducer.reduce(temp);
+			if (d.getBit(i)) {
+				temp.add(u, v);
+				BigUnsigned u1 = halveMod(reducer.reduce(temp), n);
+				temp.multiply(dMod, u);
+				temp += v;
+				v = halveMod(reducer.reduce(temp), n);
+				u = u1;
+				temp.multiply(qk, q);
+				qk = reducer.reduce(temp);
+			}
+		}
+		if (u.isZero() || v.isZero())
+			return true;
+		for (Index r = 1; r < s; r++) {
+			temp.multiply(v, v);
+			t2 = qk;
+			t2 <<= 1;
+			v = subtractMod(reducer.reduce(temp), reducer.reduce(t2), n);
+			if (v.isZero())
+				return true;
+			temp.multiply(qk, qk);
+			qk = reducer.reduce(temp);
+		}
+		return false;
+	}
+}
+
+bool isProbablePrime(const BigUnsigned &n, unsigned int rounds) {
+	if (n < 2)
+		return false;
+	if (!n.getBit(0))
+		return n == 2;
+	int t = trialDivision(n);
+	if (t != 0)
+		return t > 0;
+	// n has no small factor and is at least trialDivisionBound^2.
+	BarrettReducer reducer(n);
+	BigUnsigned d(n);
+	d -= 1;
+	Index s = d.countTrailingZeros();
+	d >>= s;
+	// BPSW: a strong probable prime test to base 2 and a strong Lucas test
+	if (!millerRabin(n, 2, d, s, reducer))
+		return false;
+	if (isPerfectSquare(n) || !strongLucas(n, reducer))
+		return false;
+	// Extra Miller-Rabin rounds to the bases 3, 5, 7, 11, ...
+	unsigned long base = 3;
+	for (unsigned int r = 0; r < rounds; r++, base += 2) {
+		while (!isSmallPrime(base))
+			base += 2;
+		if (!millerRabin(n, base, d, s, reducer))
+			return false;
+	}
+	return true;
+}
+
+namespace {
+	// Windows are sieved by the odd primes below this bound.
+	const unsigned long sieveBound = 32768;
+	// The number of odd candidates in a window
+	const Index windowSize = 4096;
+
+	/* Returns a new array of the odd primes below bound, found with the
+	 * sieve of Eratosthenes, and stores their number in count. */
+	unsigned long *oddPrimesBelow(unsigned long bound, unsigned int &count) {
+		bool *composite = new bool[bound];
+		unsigned long i, j;
+		for (i = 0; i < bound; i++)
+			composite[i] = false;
+		count = 0;
+		for (i = 3; i < bound; i += 2) {
+			if (composite[i])
+				continue;
+			count++;
+			for (j = i * i; j < bound; j += 2 * i)
+				composite[j] = true;
+		}
+		unsigned long *primes = new unsigned long[count];
+		count = 0;
+		for (i = 3; i < bound; i += 2)
+			if (!composite[i])
+				primes[count++] = i;
+		delete [] composite;
+		return primes;
+	}
+
+	/* Returns the odd primes below sieveBound and stores their number in
+	 * count.  They are sieved on the first call and kept, so that a loop
+	 * over nextPrime doesn't sieve them again for every prime. */
+	const unsigned long *windowSievePrimes(unsigned int &count) {
+		static unsigned int primeCount;
+		static const unsigned long *primes
+			= oddPrimesBelow(sieveBound, primeCount);
+		count = primeCount;
+		return primes;
+	}
+
+	/* Sets composite[i] for each i < windowSize such that start + 2i has
+	 * one of the given odd primes as a proper factor; start must be odd.
+	 * As in trialDivision, one pass over start finds its residues modulo
+	 * a whole group of primes. */
+	void sieveWindow(const BigUnsigned &start, const unsigned long *primes,
+			unsigned int count, bool *composite) {
+		Index i;
+		for (i = 0; i < windowSize; i++)
+			composite[i] = false;
+		// Only a start that fits in a block can be one of the primes.
+		bool small = (start.getLength() <= 1);
+		unsigned long product = 1;
+		unsigned int first = 0, j;
+		for (j = 0; j <= count; j++) {
+			if (j == count || product > 0xffffffffUL / primes[j]) {
+				unsigned long r = remainderSmall(start, product);
+				for (; first < j; first++) {
+					unsigned long p = primes[first];
+					/* start + 2i == 0 (mod p) when i == -start / 2, and
+					 * (p + 1) / 2 is the inverse of 2. */
+					unsigned long i0 = (p - r % p) % p * ((p + 1) / 2) % p;
+					if (small && start.getBlock(0) + 2 * i0 == p)
+						i0 += p;
+					for (i = Index(i0); i < windowSize; i += Index(p))
+						composite[i] = true;
+				}
+				product = 1;
+				if (j == count)
+					break;
+			}
+			product *= primes[j];
+		}
+	}
+}
+
+BigUnsigned nextPrime(const BigUnsigned &n) {
+	if (n < 2)
+		return BigUnsigned(2);
+	BigUnsigned start(n);
+	start += n.getBit(0) ? 2 : 1;
+	unsigned int count;
+	const unsigned long *primes = windowSievePrimes(count);
+	bool *composite = new bool[windowSize];
+	BigUnsigned candidate;
+	for (;;) {
+		sieveWindow(start, primes, count, composite);
+		Index i;
+		for (i = 0; i < windowSize; i++) {
+			if (composite[i])
+				continue;
+			candidate = BigUnsigned(Blk(i));
+			candidate <<= 1;
+			candidate += start;
+			if (isProbablePrime(candidate, 0))
+				break;
+		}
+		if (i < windowSize)
+			break;
+		candidate = BigUnsigned(Blk(windowSize));
+		candidate <<= 1;
+		start += candidate;
+	}
+	delete [] composite;
+	return candidate;
+}
+
+NumberlikeArray<BigUnsigned> primesInRange(const BigUnsigned &lo,
+		const BigUnsigned &hi) {
+	NumberlikeArray<BigUnsigned> result;
+	if (!(lo < hi))
+		return result;
+	if (lo <= 2 && hi > 2) {
+		result.allocate(16);
+		result.blk[result.len++] = 2;
+	}
+	BigUnsigned start(lo), candidate, step(windowSize);
+	step <<= 1;
+	if (!start.getBit(0))
+		start += 1;
+	unsigned int count;
+	const unsigned long *primes = windowSievePrimes(count);
+	bool *composite = new bool[windowSize];
+	for (; start < hi; start += step) {
+		sieveWindow(start, primes, count, composite);
+		for (Index i = 0; i < windowSize; i++) {
+			if (composite[i])
+				continue;
+			candidate = BigUnsigned(Blk(i));
+			candidate <<= 1;
+			candidate += start;
+			if (!(candidate < hi))
+				break;
+			if (!isProbablePrime(candidate, 0))
+				continue;
+			if (result.len == result.cap)
+				result.allocateAndCopy(result.cap == 0 ? 16 : 2 * result.cap);
+			result.blk[result.len++] = candidate;
+		}
+	}
+	delete [] composite;
+	return result;
+}
+
+namespace {
+	/* Returns the product of f[0..count), count > 0, splitting the range
+	 * in half at each level so that the big multiplications are between
+	 * numbers of similar size and can use Karatsuba's method. */
+	BigUnsigned productOfBlocks(const Blk *f, Index count) {
+		if (count <= 8) {
+			BigUnsigned ans(f[0]);
+			for (Index i = 1; i < count; i++)
+				ans.multiplyBlock(ans, f[i]);
+			return ans;
+		}
+		Index half = count / 2;
+		return productOfBlocks(f, half) * productOfBlocks(f + half, count - half);
+	}
+
+	/* Collects the prime power factors of a number.  Small factors are
+	 * multiplied together while they fit in a block, and the resulting
+	 * blocks are multiplied with productOfBlocks at the end. */
+	class FactorList {
+	public:
+		FactorList() : current(1) {}
+
+		// Multiplies in p^e.
+		void append(Blk p, unsigned long e) {
+			for (; e > 0; e--) {
+				if (current > ~Blk(0) / p) {
+					push(current);
+					current = 1;
+				}
+				current *= p;
+			}
+		}
+
+		BigUnsigned product() {
+			push(current);
+			current = 1;
+			return productOfBlocks(factors.blk, factors.len);
+		}
+
+	private:
+		void push(Blk x) {
+			if (factors.len == factors.cap)
+				factors.allocateAndCopy(factors.cap == 0 ? 16 : 2 * factors.cap);
+			factors.blk[factors.len++] = x;
+		}
+
+		NumberlikeArray<Blk> factors;
+		Blk current;
+	};
+
+	// Returns the exponent of the prime p in n!, which is the sum of n / p^i.
+	unsigned long legendre(unsigned long n, unsigned long p) {
+		unsigned long e = 0;
+		for (n /= p; n > 0; n /= p)
+			e += n;
+		return e;
+	}
+
+	/* Returns the odd part of the swinging factorial n! / (n/2)!^2.  The
+	 * exponent of an odd prime p in it is the number of odd numbers among
+	 * n / p, n / p^2, and so on. */
+	BigUnsigned oddSwing(unsigned long n, const unsigned long *primes,
+			unsigned int count) {
+		FactorList f;
+		for (unsigned int i = 0; i < count && primes[i] <= n; i++) {
+			unsigned long e = 0;
+			for (unsigned long q = n / primes[i]; q > 0; q /= primes[i])
+				e += q & 1;
+			f.append(primes[i], e);
+		}
+		return f.product();
+	}
+
+	// Returns the odd part of n!, which is oddFactorial(n/2)^2 * oddSwing(n).
+	BigUnsigned oddFactorial(unsigned long n, const unsigned long *primes,
+			unsigned int count) {
+		if (n < 3)
+			return BigUnsigned(1);
+		BigUnsigned half = oddFactorial(n / 2, primes, count), ans;
+		ans.multiply(half, half);
+		return ans * oddSwing(n, primes, count);
+	}
+
+	/* Returns n! / (ks[0]! ks[1]! ... ks[count-1]!), where the ks sum to n.
+	 * The largest k cancels all but m = n - k of the factors of n!.  If m is
+	 * small next to n, the answer is built up one factor at a time: after
+	 * the factor N, ans is the product so far times the binomial
+	 * coefficient C(N, i) for the i factors taken from the current k, so
+	 * each division by i is exact.  That avoids sieving up to n, which
+	 * costs n bytes however small the answer is.  Otherwise the answer
+	 * comes from the exponent of each prime p <= n: legendre(n, p) minus the
+	 * sum of legendre(ks[i], p). */
+	BigUnsigned factorialQuotient(unsigned long n, const unsigned long *ks,
+			Index count) {
+		Index top = 0, j;
+		for (j = 1; j < count; j++)
+			if (ks[j] > ks[top])
+				top = j;
+		unsigned long m = (count == 0) ? 0 : n - ks[top];
+		if (m <= 64 || m <= n / m) {
+			BigUnsigned ans(1);
+			Blk N = n - m;
+			for (j = 0; j < count; j++) {
+				if (j == top)
+					continue;
+				for (Blk i = 1; i <= ks[j]; i++) {
+					N++;
+					ans.multiplyBlock(ans, N);
+					ans.divideBlock(ans, i);
+				}
+			}
+			return ans;
+		}
+		// The sieve below needs n + 1 entries.
+		if (n == ~0UL)
+			throw (count == 2)
+				? "BigInteger binomial: The result is too big"
+				: "BigInteger multinomial: The result is too big";
+		unsigned int primeCount;
+		unsigned long *primes = oddPrimesBelow(n + 1, primeCount);
+		FactorList f;
+		for (unsigned int i = 0; i <= primeCount; i++) {
+			// Do 2 first, then the odd primes.
+			unsigned long p = (i == 0) ? 2 : primes[i - 1];
+			if (p > n)
+				break;
+			unsigned long e = legendre(n, p);
+			for (Index j = 0; j < count; j++)
+				e -= legendre(ks[j], p);
+			f.append(p, e);
+		}
+		delete [] primes;
+		return f.product();
+	}
+}
+
+/* Luschny's prime-swing method: n! is (n/2)!^2 times the swinging
+ * factorial, whose prime factorization is easy to read off.  The power of
+ * 2 in n!, n minus the number of 1 bits of n, is shifted in at the end. */
+BigUnsigned factorial(unsigned long n) {
+	if (n < 2)
+		return BigUnsigned(1);
+	// The sieve needs n + 1 entries.
+	if (n == ~0UL)
+		throw "BigInteger factorial: The result is too big";
+	unsigned int count;
+	unsigned long *primes = oddPrimesBelow(n + 1, count);
+	BigUnsigned ans = oddFactorial(n, primes, count);
+	delete [] primes;
+	ans <<= int(n - BigUnsigned::blockPopcount(n));
+	return ans;
+}
+
+BigUnsigned binomial(unsigned long n, unsigned long k) {
+	if (k > n)
+		return BigUnsigned(0);
+	unsigned long ks[2] = { k, n - k };
+	return factorialQuotient(n, ks, 2);
+}
+
+BigUnsigned multinomial(const unsigned long *ks, BigUnsigned::Index count) {
+	unsigned long n = 0;
+	for (Index i = 0; i < count; i++) {
+		if (ks[i] > ~0UL - n)
+			throw "BigInteger multinomial: The sum of the arguments is too big";
+		n += ks[i];
+	}
+	return factorialQuotient(n, ks, count);
+}
+
+namespace {
+	/* Sets f = F(n) and l = L(n) by running through the bits of n with the
+	 * doubling identities
+	 *    F(2k) = F(k) L(k),        L(2k) = L(k)^2 - 2 (-1)^k,
+	 * and stepping from 2k to 2k + 1 with
+	 *    F(2k+1) = (F(2k) + L(2k)) / 2,  L(2k+1) = (5 F(2k) + L(2k)) / 2.
+	 * That is one multiplication and one squaring per bit. */
+	void fibonacciLucas(unsigned long n, BigUnsigned &f, BigUnsigned &l) {
+		BigUnsigned t, u;
+		f = 0;
+		l = 2;
+		bool kOdd = false;
+		unsigned long bit = 1;
+		while (bit <= n / 2)
+			bit <<= 1;
+		for (; n != 0 && bit != 0; bit >>= 1) {
+			t.multiply(f, l);
+			u.multiply(l, l);
+			if (kOdd)
+				u += 2;
+			else
+				u -= 2;
+			f = t;
+			l = u;
+			kOdd = false;
+			if ((n & bit) != 0) {
+				t.add(f, l);
+				t >>= 1;
+				u.multiplyBlock(f, 5);
+				u += l;
+				u >>= 1;
+				f = t;
+				l = u;
+				kOdd = true;
+			}
+		}
+	}
+
+	/* Sets a = F(n) % m and b = F(n+1) % m.  Halving isn't possible modulo
+	 * an even m, so this doubles with
+	 *    F(2k) = F(k) (2 F(k+1) - F(k)),  F(2k+1) = F(k)^2 + F(k+1)^2
+	 * instead, at the cost of a third multiplication per bit. */
+	void fibonacciPairMod(const BigUnsigned &n, const BigUnsigned &m,
+			BigUnsigned &a, BigUnsigned &b) {
+		if (m.isZero())
+			throw "BigInteger fibonacciMod: Modulus is zero";
+		BarrettReducer reducer(m);
+		BigUnsigned c, d, e, t;
+		a = 0;
+		b = reducer.reduce(1);
+		Index i = n.bitLength();
+		while (i > 0) {
+			i--;
+			// d = 2 F(k+1) - F(k), kept nonnegative by adding m.
+			d = b;
+			d <<= 1;
+			d += m;
+			d -= a;
+			t.multiply(a, d);
+			c = reducer.reduce(t);
+			t.multiply(a, a);
+			d.multiply(b, b);
+			t += d;
+			e = reducer.reduce(t);
+			if (n.getBit(i)) {
+				a = e;
+				c += e;
+				b = reducer.reduce(c);
+			} else {
+				a = c;
+				b = e;
+			}
+		}
+	}
+}
+
+BigUnsigned fibonacci(unsigned long n) {
+	BigUnsigned f, l;
+	fibonacciLucas(n, f, l);
+	return f;
+}
+
+BigUnsigned lucas(unsigned long n) {
+	BigUnsigned f, l;
+	fibonacciLucas(n, f, l);
+	return l;
+}
+
+BigUnsigned fibonacciMod(const BigUnsigned &n, const BigUnsigned &m) {
+	BigUnsigned a, b;
+	fibonacciPairMod(n, m, a, b);
+	return a;
+}
+
+// L(n) = 2 F(n+1) - F(n)
+BigUnsigned lucasMod(const BigUnsigned &n, const BigUnsigned &m) {
+	BigUnsigned a, b;
+	fibonacciPairMod(n, m, a, b);
+	b <<= 1;
+	b += m;
+	b -= a;
+	BarrettReducer reducer(m);
+	return reducer.reduce(b);
+}
+
+namespace {
+	/* Moduli at least this many blocks long get their Barrett reciprocal by
+	 * Newton's iteration instead of long division, and remainder trees
+	 * reduce modulo such nodes with a BarrettReducer. */
+	const Index reciprocalThreshold = 400;
+
+	/* All the levels of a product tree over count > 0 values, stored bottom
+	 * up in one array.  Level 0 is a copy of the values, and node i of level
+	 * j+1 is the product of nodes 2i and 2i+1 of level j, or a copy of node
+	 * 2i if that has no partner.  The last node is the root. */
+	class ProductLevels {
+	public:
+		ProductLevels(const BigUnsigned *values, Index count);
+		~ProductLevels() {
+			delete [] start;
+			delete [] nodes;
+		}
+
+		// Level j holds nodes[start[j]] through nodes[start[j+1] - 1].
+		Index depth;
+		Index *start;
+		BigUnsigned *nodes;
+
+	private:
+		ProductLevels(const ProductLevels &);
+		void operator =(const ProductLevels &);
+	};
+
+	ProductLevels::ProductLevels(const BigUnsigned *values, Index count) {
+		// Count the levels and nodes first.
+		Index total = count, width;
+		depth = 1;
+		for (width = count; width > 1; width = (width + 1) / 2) {
+			total += (width + 1) / 2;
+			depth++;
+		}
+		start = new Index[depth + 1];
+		nodes = new BigUnsigned[total];
+		for (Index i = 0; i < count; i++)
+			nodes[i] = values[i];
+		start[0] = 0;
+		width = count;
+		for (Index j = 0; j + 1 < depth; j++) {
+			const BigUnsigned *below = nodes + start[j];
+			start[j + 1] = start[j] + width;
+			BigUnsigned *above = nodes + start[j + 1];
+			for (Index i = 0; 2 * i < width; i++) {
+				if (2 * i + 1 < width)
+					above[i].multiply(below[2 * i], below[2 * i + 1]);
+				else
+					above[i] = below[2 * i];
+			}
+			width = (width + 1) / 2;
+		}
+		start[depth] = total;
+	}
+
+	/* Sets out[i] to x % v (or x % v^2 if squared) for each value v at the
+	 * bottom of the tree.  Each node's remainder is reduced by its children,
+	 * so no division has a dividend much longer than its divisor except the
+	 * first one, by the root, and long nodes get a BarrettReducer instead of
+	 * a division.  out doubles as the working space: on each
+	 * level the remainders are computed from the last to the first, so each
+	 * parent's remainder is read before it is overwritten. */
+	void reduceDown(const ProductLevels &t, const BigUnsigned &x, bool squared,
+			BigUnsigned *out) {
+		BigUnsigned q, square;
+		Index j = t.depth;
+		out[0] = x;
+		while (j > 0) {
+			j--;
+			for (Index i = t.start[j + 1] - t.start[j]; i > 0; ) {
+				i--;
+				if (i != 0)
+					out[i] = out[i / 2];
+				const BigUnsigned *node = &t.nodes[t.start[j] + i];
+				if (squared) {
+					// Skip squaring when x is plainly shorter than v^2.
+					if (out[i].getLength() < 2 * node->getLength() - 1)
+						continue;
+					square.multiply(*node, *node);
+					node = &square;
+				}
+				if (out[i] < *node)
+					continue;
+				if (node->getLength() >= reciprocalThreshold) {
+					BarrettReducer reducer(*node);
+					out[i] = reducer.reduce(out[i]);
+				} else
+					out[i].divideWithRemainder(*node, q);
+			}
+		}
+	}
+}
+
+BigUnsigned productTree(const BigUnsigned *values, BigUnsigned::Index count) {
+	if (count == 0)
+		return BigUnsigned(1);
+	if (count == 1)
+		return values[0];
+	Index half = count / 2;
+	return productTree(values, half) * productTree(values + half, count - half);
+}
+
+void remainderTree(const BigUnsigned &x, const BigUnsigned *moduli,
+		BigUnsigned::Index count, BigUnsigned *remainders) {
+	if (count == 0)
+		return;
+	ProductLevels tree(moduli, count);
+	reduceDown(tree, x, false, remainders);
+}
+
+/* Bernstein's batch gcd.  With P the product of all the moduli and N one of
+ * them, (P mod N^2) / N is congruent modulo N to the product of the others,
+ * so its gcd with N is the one we want.  The remainders come from a single
+ * descent of the product tree with squared nodes. */
+void batchGcd(const BigUnsigned *moduli, BigUnsigned::Index count,
+		BigUnsigned *gcds) {
+	for (Index i = 0; i < count; i++)
+		if (moduli[i].isZero())
+			throw "BigInteger batchGcd: moduli must be nonzero";
+	if (count == 0)
+		return;
+	ProductLevels tree(moduli, count);
+	reduceDown(tree, tree.nodes[tree.start[tree.depth] - 1], true, gcds);
+	// Use the tree's copies of the moduli in case gcds overlaps them.
+	BigUnsigned q;
+	for (Index i = 0; i < count; i++) {
+		gcds[i].divideWithRemainder(tree.nodes[i], q);
+		gcds[i] = gcd(tree.nodes[i], q);
+	}
+}
+
+int jacobi(const BigInteger &a, const BigUnsigned &n) {
+	if ((n.getBlock(0) & 1) == 0)
+		throw "BigInteger jacobi: n must be odd";
+	return jacobiSymbol((a % n).getMagnitude(), n);
+}
+
+namespace {
+	// Returns x * y % m, where m is the reducer's modulus.
+	BigUnsigned multiplyMod(const BigUnsigned &x, const BigUnsigned &y,
+			const BarrettReducer &reducer) {
+		BigUnsigned product;
+		product.multiply(x, y);
+		return reducer.reduce(product);
+	}
+}
+
+/* For p == 3 mod 4, a^((p+1)/4) is a root, since its square is
+ * a * a^((p-1)/2) = a.  For p == 5 mod 8, Atkin's method: with
+ * v = (2a)^((p-5)/8) and i = 2a v^2, which is a square root of -1, the root
+ * is a v (i - 1).  Otherwise p - 1 = q 2^s with s >= 3, and Tonelli-Shanks
+ * starts from x = a^((q+1)/2), whose square is a times t = a^q, and fixes up
+ * x with powers of c = z^q for a non-square z until t becomes 1; each round
+ * lowers the order of t. */
+BigUnsigned modSqrt(const BigInteger &a, const BigUnsigned &p) {
+	if (p == 2)
+		return (a % p).getMagnitude();
+	if ((p.getBlock(0) & 1) == 0)
+		throw "BigInteger modSqrt: p must be an odd prime";
+	BigUnsigned r = (a % p).getMagnitude();
+	if (r.isZero())
+		return BigUnsigned();
+	if (jacobiSymbol(r, p) != 1)
+		throw "BigInteger modSqrt: a is not a square modulo p";
+	BarrettReducer reducer(p);
+	BigUnsigned x, e;
+	Blk p8 = p.getBlock(0) & 7;
+	if ((p8 & 3) == 3) {
+		e = p >> 2;
+		e++;
+		x = modexpReduced(r, e, reducer);
+	} else if (p8 == 5) {
+		BigUnsigned r2 = r << 1, v, i;
+		if (r2 >= p)
+			r2 -= p;
+		v = modexpReduced(r2, p >> 3, reducer);
+		i = multiplyMod(r2, multiplyMod(v, v, reducer), reducer);
+		// i - 1 is never negative: i == 0 would make a zero.
+		i--;
+		x = multiplyMod(multiplyMod(r, v, reducer), i, reducer);
+	} else {
+		BigUnsigned q = p - 1;
+		Index s = q.countTrailingZeros();
+		q >>= s;
+		/* Find a non-square z; half of all residues are.  If p is a square,
+		 * (z/p) is never -1, so reject that case first. */
+		if (isPerfectSquare(p))
+			throw "BigInteger modSqrt: p must be an odd prime";
+		unsigned long z = 2;
+		while (jacobiSymbol(z, p) != -1)
+			z++;
+		BigUnsigned c = modexpReduced(z, q, reducer), t, b;
+		e = q >> 1;
+		x = modexpReduced(r, e, reducer);
+		t = multiplyMod(r, multiplyMod(x, x, reducer), reducer);
+		x = multiplyMod(x, r, reducer);
+		Index m = s;
+		while (t != 1) {
+			// The least i with t^(2^i) == 1; it is below m if p is prime.
+			Index i = 0;
+			for (b = t; b != 1; b = multiplyMod(b, b, reducer))
+				if (++i == m)
+					throw "BigInteger modSqrt: p must be an odd prime";
+			// b = c^(2^(m-i-1))
+			b = c;
+			for (Index j = i + 1; j < m; j++)
+				b = multiplyMod(b, b, reducer);
+			c = multiplyMod(b, b, reducer);
+			x = multiplyMod(x, b, reducer);
+			t = multiplyMod(t, c, reducer);
+			m = i;
+		}
+	}
+	/* The first two branches compute a root without checking that p is
+	 * prime, and for a composite p the Jacobi symbol can be 1 for a
+	 * non-square, so make sure x really is a root. */
+	if (multiplyMod(x, x, reducer) != r)
+		throw "BigInteger modSqrt: p must be an odd prime";
+	// Of the two roots x and p - x, return the smaller one.
+	BigUnsigned y = p - x;
+	return (y < x) ? y : x;
+}
+
+namespace {
+	/* Returns floor(B^(2k) / m), where m is nonzero and k is its length in
+	 * blocks.  Above the threshold, take the reciprocal x of the top h
+	 * blocks of m, h = k/2 + 2, and scale it up; its relative error is
+	 * below B^(1-h).  One Newton step x += x * (B^(2k) - m*x) / B^(2k)
+	 * squares the relative error, which leaves x within a few units of the
+	 * answer, and a final remainder check makes it exact.  The cost is a
+	 * few multiplications at each of the halving sizes. */
+	BigUnsigned reciprocal(const BigUnsigned &m) {
+		Index k = m.getLength();
+		BigUnsigned power, x;
+		power.setBlock(2 * k, 1);
+		if (k < reciprocalThreshold) {
+			power.divideWithRemainder(m, x);
+			return x;
+		}
+		Index h = k / 2 + 2, l = k - h;
+		BigUnsigned p, e;
+		p.bitShiftRight(m, l * BigUnsigned::N);
+		x.bitShiftLeft(reciprocal(p), l * BigUnsigned::N);
+		// The Newton step, with the sign of B^(2k) - m*x handled by hand
+		p.multiply(m, x);
+		if (p <= power) {
+			e.subtract(power, p);
+			p.multiply(x, e);
+			p >>= 2 * k * BigUnsigned::N;
+			x += p;
+		} else {
+			e.subtract(p, power);
+			p.multiply(x, e);
+			p >>= 2 * k * BigUnsigned::N;
+			x -= p;
+		}
+		// Make it exact.
+		p.multiply(m, x);
+		while (p > power) {
+			x--;
+			p -= m;
+		}
+		e.subtract(power, p);
+		while (e >= m) {
+			x++;
+			e -= m;
+		}
+		return x;
+	}
+}
+
+BarrettReducer::BarrettReducer(const BigUnsigned &m) : m(m), k(m.getLength()) {
+	if (k == 0)
+		return;
+	// mu = floor(B^(2k) / m)
+	mu = reciprocal(m);
+}
+
+/* This is Algorithm 14.42 of the Handbook of Applied Cryptography with the
+ * final correction done on the untruncated difference: for x < B^(2k), the
+ * estimate q below is at most 2 less than floor(x / m), so x - q*m < 3m. */
+BigUnsigned BarrettReducer::reduce(const BigUnsigned &x) const {
+	BigUnsigned q;
+	return reduce(x, q);
+}
+
+BigUnsigned BarrettReducer::reduce(const BigUnsigned &x, BigUnsigned &q) const {
+	BigUnsigned r(x);
+	if (k == 0 || x.getLength() > 2 * k) {
+		r.divideWithRemainder(m, q);
+		return r;
+	}
+	BigUnsigned t;
+	// q = floor(floor(x / B^(k-1)) * mu / B^(k+1))
+	t.bitShiftRight(x, (k - 1) * BigUnsigned::N);
+	q.multiply(t, mu);
+	q >>= (k + 1) * BigUnsigned::N;
+	t.multiply(q, m);
+	r -= t;
+	while (r >= m) {
+		r -= m;
+		q++;
+	}
+	return r;
+}
+
+FixedBaseExp::FixedBaseExp(const BigInteger &base, const BigUnsigned &modulus)
+		: base((base % modulus).getMagnitude()), reducer(modulus) {
+	init(modulus.bitLength());
+}
+
+FixedBaseExp::FixedBaseExp(const BigInteger &base, const BigUnsigned &modulus,
+		BigUnsigned::Index maxExponentBits)
+		: base((base % modulus).getMagnitude()), reducer(modulus) {
+	init(maxExponentBits);
+}
+
+void FixedBaseExp::init(BigUnsigned::Index maxExponentBits) {
+	// More teeth mean fewer steps per call but a table twice as big.
+	h = (maxExponentBits <= 32) ? 2
+		: (maxExponentBits <= 128) ? 4
+		: (maxExponentBits <= 512) ? 6
+		: 8;
+	d = (maxExponentBits + h - 1) / h;
+	if (d == 0)
+		d = 1;
+	unsigned int tableSize = 1U << h;
+	table = new BigUnsigned[tableSize];
+	table[0] = 1;
+	// Fill in the entries for single teeth: g = base^(2^(t*d)).
+	BigUnsigned g(base), temp;
+	for (unsigned int t = 0; t < h; t++) {
+		if (t > 0)
+			for (BigUnsigned::Index i = 0; i < d; i++) {
+				temp.multiply(g, g);
+				g = reducer.reduce(temp);
+			}
+		table[1U << t] = g;
+	}
+	// Every other entry is its top tooth times the entry for the rest.
+	for (unsigned int j = 3; j < tableSize; j++) {
+		unsigned int top = 1U << (h - 1);
+		while ((j & top) == 0)
+			top >>= 1;
+		if (j == top)
+			continue;
+		temp.multiply(table[top], table[j - top]);
+		table[j] = reducer.reduce(temp);
+	}
+}
+
+FixedBaseExp::~FixedBaseExp() {
+	delete [] table;
+}
+
+BigUnsigned FixedBaseExp::pow(const BigUnsigned &exponent) const {
+	if (exponent.bitLength() > h * d)
+		return modexp(base, exponent, reducer.getModulus());
+	BigUnsigned ans = 1, temp;
+	bool started = false;
+	BigUnsigned::Index i = d;
+	// For each column of the comb, most to least significant...
 	while (i > 0) {
 		i--;
-		// Square.
-		ans *= ans;
-		ans %= modulus;
-		// And multiply if the bit is a 1.
-		if (exponent.getBit(i)) {
-			ans *= base2;
-			ans %= modulus;
+		// Square, unless ans is still 1.
+		if (started) {
+			temp.multiply(ans, ans);
+			ans = reducer.reduce(temp);
+		}
+		// Gather bit i of each tooth into an index into the table.
+		unsigned int j = 0;
+		for (unsigned int t = h; t > 0; t--)
+			j = (j << 1) | (exponent.getBit((t - 1) * d + i) ? 1 : 0);
+		if (j != 0) {
+			temp.multiply(ans, table[j]);
+			ans = reducer.reduce(temp);
+			started = true;
 		}
 	}
 	return ans;
@@ -18,8 +18,170 @@ void extendedEuclidean(BigInteger m, BigInteger n,
  * they have a common factor. */
 BigUnsigned modinv(const BigInteger &x, const BigUnsigned &n);
 
+/* Batch inversion by Montgomery's trick: sets inverses[i] to the inverse of
+ * values[i] modulo modulus for 0 <= i < count, at the cost of one modinv and
+ * about 3*count modular multiplications.  Throws an exception if any of the
+ * values has a common factor with the modulus. */
+void batchModinv(const BigInteger *values, BigUnsigned::Index count,
+		const BigUnsigned &modulus, BigUnsigned *inverses);
+
 // Returns (base ^ exponent) % modulus.
 BigUnsigned modexp(const BigInteger &base, const BigUnsigned &exponent,
 		const BigUnsigned &modulus);
 
+/* Simultaneous exponentiation: returns the product of
+ * bases[i] ^ exponents[i] for 0 <= i < count, reduced modulo modulus.  The
+ * bases share a single chain of squarings, so this is much cheaper than
+ * count separate calls to modexp. */
+BigUnsigned multiExp(const BigInteger *bases, const BigUnsigned *exponents,
+		BigUnsigned::Index count, const BigUnsigned &modulus);
+
+/* Integer roots by Newton's iteration, started from a power of 2 chosen by
+ * bitLength.  isqrt(x) returns floor(sqrt(x)), and isqrtRem sets s to that
+ * and r to x - s*s.  iroot(x, k) returns floor(x^(1/k)) for k >= 1. */
+BigUnsigned isqrt(const BigUnsigned &x);
+void isqrtRem(const BigUnsigned &x, BigUnsigned &s, BigUnsigned &r);
+BigUnsigned iroot(const BigUnsigned &x, unsigned int k);
+
+/* Perfect power detection.  Most non-squares are rejected by their residues
+ * modulo a few small numbers, so isPerfectSquare only takes a square root
+ * for about one candidate in 600.  perfectPowerExponent(x) returns the
+ * largest k such that x is a perfect k-th power (so 1 if x is not a perfect
+ * power at all), or 0 for x == 0 and x == 1, which are k-th powers for all
+ * k; it filters each candidate exponent the same way before calling
+ * iroot. */
+bool isPerfectSquare(const BigUnsigned &x);
+unsigned int perfectPowerExponent(const BigUnsigned &x);
+
+/* Baillie-PSW probable prime test.  After trial division by the primes below
+ * 1000, n must pass a strong Miller-Rabin test to base 2 and a strong Lucas
+ * test with Selfridge's parameters; no composite is known to pass both.
+ * Then come `rounds' further Miller-Rabin tests to the bases 3, 5, 7, 11,
+ * and so on.  All the tests share one reduction context for n.  Numbers
+ * below 10^6 get a definite answer from the trial division alone. */
+bool isProbablePrime(const BigUnsigned &n, unsigned int rounds);
+
+/* Prime generation.  nextPrime(n) returns the smallest probable prime greater
+ * than n, and primesInRange(lo, hi) returns the probable primes p with
+ * lo <= p < hi in increasing order.  Both sieve windows of candidates with
+ * the odd primes below 2^15 and run isProbablePrime (with no extra rounds)
+ * only on the survivors. */
+BigUnsigned nextPrime(const BigUnsigned &n);
+NumberlikeArray<BigUnsigned> primesInRange(const BigUnsigned &lo,
+		const BigUnsigned &hi);
+
+/* Combinatorics.  factorial(n) uses Luschny's prime-swing method, and
+ * binomial(n, k) and multinomial (the number of ways to split
+ * ks[0] + ... + ks[count-1] objects into groups of those sizes) multiply
+ * out their prime factorizations.  The factors are multiplied in balanced
+ * product trees, so most of the work is in large, evenly sized products.
+ * When all but the largest group are small next to n, as in binomial(n, 2)
+ * for huge n, they take a running product instead, since finding the
+ * primes up to n would cost far more than the answer.
+ * binomial(n, k) is 0 for k > n.  Answers too big to compute throw an
+ * exception. */
+BigUnsigned factorial(unsigned long n);
+BigUnsigned binomial(unsigned long n, unsigned long k);
+BigUnsigned multinomial(const unsigned long *ks, BigUnsigned::Index count);
+
+/* Fibonacci and Lucas numbers by fast doubling, in O(log n) multiplications.
+ * fibonacciMod and lucasMod return F(n) % m and L(n) % m for any m > 0
+ * without computing the full numbers, and throw if m is zero. */
+BigUnsigned fibonacci(unsigned long n);
+BigUnsigned lucas(unsigned long n);
+BigUnsigned fibonacciMod(const BigUnsigned &n, const BigUnsigned &m);
+BigUnsigned lucasMod(const BigUnsigned &n, const BigUnsigned &m);
+
+/* Product and remainder trees.  productTree returns the product of
+ * values[0..count) (1 if count is 0), splitting the range in half at each
+ * level so that the big multiplications are between numbers of similar size.
+ * remainderTree sets remainders[i] to x % moduli[i] for 0 <= i < count: it
+ * reduces x modulo the root of the moduli's product tree and then modulo each
+ * node on the way down, so no modulus is ever divided into anything much
+ * longer than itself.  As with %, a zero modulus leaves x unchanged. */
+BigUnsigned productTree(const BigUnsigned *values, BigUnsigned::Index count);
+void remainderTree(const BigUnsigned &x, const BigUnsigned *moduli,
+		BigUnsigned::Index count, BigUnsigned *remainders);
+
+/* Batch gcd: sets gcds[i] to the gcd of moduli[i] and the product of all the
+ * other moduli, for 0 <= i < count.  A result other than 1 means the modulus
+ * shares a factor with some other one.  Bernstein's method takes a product
+ * tree and one pass down it, so the cost is a few multiplications of each
+ * tree level instead of count^2 / 2 gcds.  Throws an exception if any
+ * modulus is zero. */
+void batchGcd(const BigUnsigned *moduli, BigUnsigned::Index count,
+		BigUnsigned *gcds);
+
+/* Returns the Jacobi symbol (a/n) for odd n: 0 if a and n have a common
+ * factor, and otherwise 1 or -1; for prime n, 1 means that a is a square
+ * modulo n.  Computed by the binary algorithm, without divisions after the
+ * first reduction of a.  Throws an exception if n is even. */
+int jacobi(const BigInteger &a, const BigUnsigned &n);
+
+/* Returns a square root of a modulo an odd prime p (also p == 2), namely the
+ * smaller of the two roots x and p - x, or throws an exception if a is not a
+ * square modulo p.  For p == 3 mod 4 and p == 5 mod 8 this costs one modexp;
+ * other primes use the Tonelli-Shanks algorithm. */
+BigUnsigned modSqrt(const BigInteger &a, const BigUnsigned &p);
+
+/* A BarrettReducer reduces numbers modulo a fixed modulus m without long
+ * division.  The constructor precomputes mu = floor(B^(2k) / m), where
+ * B = 2^N is the block base and k is the length of m in blocks, by one long
+ * division or, for moduli hundreds of blocks long, by Newton's iteration;
+ * after that, reduce(x) costs two multiplications and a few subtractions for
+ * any x < B^(2k), which includes every x < m^2.  Longer inputs are handled
+ * with an ordinary divideWithRemainder.
+ *
+ * Unlike Montgomery reduction, this works for even moduli as well as odd
+ * ones.  As with BigUnsigned's %, reducing modulo zero leaves x unchanged. */
+class BarrettReducer {
+public:
+	BarrettReducer(const BigUnsigned &m);
+
+	const BigUnsigned &getModulus() const { return m; }
+
+	// Returns x % m.
+	BigUnsigned reduce(const BigUnsigned &x) const;
+	// Returns x % m and sets q to x / m.
+	BigUnsigned reduce(const BigUnsigned &x, BigUnsigned &q) const;
+
+protected:
+	BigUnsigned m, mu;
+	// The length of m in blocks
+	BigUnsigned::Index k;
+};
+
+/* A FixedBaseExp computes powers of one base modulo one modulus for many
+ * different exponents.  The constructor builds a Lim-Lee comb table of
+ * 2^h products of the powers base^(2^(t*d)), where h*d covers
+ * maxExponentBits (which defaults to the bit length of the modulus).  Each
+ * call to pow then takes only d squarings and at most d multiplications.
+ * Longer exponents are still accepted but go through plain modexp. */
+class FixedBaseExp {
+public:
+	FixedBaseExp(const BigInteger &base, const BigUnsigned &modulus);
+	FixedBaseExp(const BigInteger &base, const BigUnsigned &modulus,
+			BigUnsigned::Index maxExponentBits);
+	~FixedBaseExp();
+
+	// Returns (base ^ exponent) % modulus.
+	BigUnsigned pow(const BigUnsigned &exponent) const;
+
+protected:
+	void init(BigUnsigned::Index maxExponentBits);
+
+	BigUnsigned base;
+	BarrettReducer reducer;
+	// Number of teeth of the comb, and the spacing between them in bits
+	unsigned int h;
+	BigUnsigned::Index d;
+	// table[j] is the product of base^(2^(t*d)) over the 1-bits t of j.
+	BigUnsigned *table;
+
+private:
+	// Copying would duplicate the whole table, so it is not supported.
+	FixedBaseExp(const FixedBaseExp &);
+	void operator =(const FixedBaseExp &);
+};
+
 #endif
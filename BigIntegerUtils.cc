@@ -1,8 +1,111 @@
 #include "BigIntegerUtils.hh"
 #include "BigUnsignedInABase.hh"
+#include "BigIntegerAlgorithms.hh"
+
+namespace {
+	typedef BigUnsigned::Index Index;
+
+	/* Numbers shorter than this many blocks are converted directly by
+	 * BigUnsignedInABase, which takes time quadratic in the length. */
+	const Index directConversionThreshold = 20;
+	/* Powers at least this many blocks long are divided by with a
+	 * BarrettReducer.  Below it, the reducer's own setup takes a long
+	 * division, so it saves little over dividing directly. */
+	const Index barrettThreshold = 400;
+
+	/* The powers used by the divide-and-conquer conversion below.  With
+	 * c = base^digits the largest power of the base that fits in a block,
+	 * powers[i] = c^(2^i), so each is the square of the one before; they
+	 * stop at the first one whose square could exceed x.  Long powers get a
+	 * BarrettReducer, which all the divisions on that level of the
+	 * recursion share. */
+	class PowerTable {
+	public:
+		PowerTable(const BigUnsigned &x, BigUnsignedInABase::Base base);
+		~PowerTable() {
+			for (Index i = 0; i < count; i++)
+				delete reducers[i];
+		}
+
+		// The number of base-`base' digits in powers[0]
+		Index digits;
+		Index count;
+		BigUnsigned powers[8 * sizeof(Index)];
+		BarrettReducer *reducers[8 * sizeof(Index)];
+
+	private:
+		PowerTable(const PowerTable &);
+		void operator =(const PowerTable &);
+	};
+
+	PowerTable::PowerTable(const BigUnsigned &x,
+			BigUnsignedInABase::Base base) {
+		BigUnsigned::Blk c = base;
+		for (digits = 1; c <= BigUnsigned::Blk(~BigUnsigned::Blk(0)) / base;
+				digits++)
+			c *= base;
+		powers[0] = c;
+		reducers[0] = 0;
+		count = 1;
+		// The square of powers[count-1] is at least 2*L - 1 blocks long.
+		while (2 * powers[count - 1].getLength() - 1 <= x.getLength()) {
+			powers[count].multiply(powers[count - 1], powers[count - 1]);
+			reducers[count] = 0;
+			count++;
+		}
+		for (Index i = 0; i < count; i++)
+			if (powers[i].getLength() >= barrettThreshold)
+				reducers[i] = new BarrettReducer(powers[i]);
+	}
+
+	/* Appends the digits of x, where x < powers[i]^2, to out.  If width is
+	 * nonzero, x is padded with leading zeros to exactly that many digits.
+	 * x is split into its quotient and remainder by powers[i], each of which
+	 * is converted recursively, until the pieces are short enough to
+	 * convert directly. */
+	void appendDigits(std::string &out, const BigUnsigned &x, Index i,
+			Index width, const PowerTable &t, BigUnsignedInABase::Base base) {
+		if (t.powers[i].getLength() < directConversionThreshold) {
+			std::string s(BigUnsignedInABase(x, base));
+			if (width > s.length())
+				out.append(width - s.length(), '0');
+			out += s;
+			return;
+		}
+		// Skip powers above the top digit of x rather than print zeros.
+		if (width == 0 && x < t.powers[i]) {
+			appendDigits(out, x, i - 1, 0, t, base);
+			return;
+		}
+		BigUnsigned q, r;
+		if (t.reducers[i] != 0)
+			r = t.reducers[i]->reduce(x, q);
+		else {
+			r = x;
+			r.divideWithRemainder(t.powers[i], q);
+		}
+		Index half = t.digits << i;
+		appendDigits(out, q, i - 1, (width == 0) ? 0 : width - half, t, base);
+		appendDigits(out, r, i - 1, half, t, base);
+	}
+
+	/* Returns the digits of x in the given base, which must be between 2 and
+	 * 36.  Short numbers go straight to BigUnsignedInABase; longer ones are
+	 * split by a table of powers of the base, so the conversion costs a few
+	 * multiplications of each size instead of quadratic time. */
+	std::string toStringInBase(const BigUnsigned &x,
+			BigUnsignedInABase::Base base) {
+		if (x.getLength() < 2 * directConversionThreshold)
+			return std::string(BigUnsignedInABase(x, base));
+		PowerTable t(x, base);
+		std::string s;
+		appendDigits(s, x, t.count - 1, 0, t, base);
+		return s;
+	}
+}
 
 std::string bigUnsignedToString(const BigUnsigned &x) {
-	return std::string(BigUnsignedInABase(x, 10));
+	return toStringInBase(x, 10);
 }
 
 std::string bigIntegerToString(const BigInteger &x) {
@@ -37,8 +140,7 @@ std::ostream &operator <<(std::ostream &os, const BigUnsigned &x) {
 			os << '0';
 	} else
 		throw "std::ostream << BigUnsigned: Could not determine the desired base from output-stream flags";
-	std::string s = std::string(BigUnsignedInABase(x, base));
-	os << s;
+	os << toStringInBase(x, base);
 	return os;
 }
 
@@ -4,12 +4,17 @@
 #include "BigInteger.hh"
 #include <string>
 #include <iostream>
+#include <cstddef>
+#include <functional>
 
 /* This file provides:
  * - Convenient std::string <-> BigUnsigned/BigInteger conversion routines
- * - std::ostream << operators for BigUnsigned/BigInteger */
+ * - std::ostream << operators for BigUnsigned/BigInteger
+ * - std::hash specializations for BigUnsigned/BigInteger */
 
-// std::string conversion routines.  Base 10 only.
+/* std::string conversion routines.  Base 10 only.  Converting a long number
+ * to a string (or to an ostream) splits it by powers of the base, which is
+ * much faster than digit-at-a-time conversion for thousands of digits. */
 std::string bigUnsignedToString(const BigUnsigned &x);
 std::string bigIntegerToString(const BigInteger &x);
 BigUnsigned stringToBigUnsigned(const std::string &s);
@@ -26,6 +31,24 @@ std::ostream &operator <<(std::ostream &os, const BigUnsigned &x);
 // My somewhat arbitrary policy: a negative sign comes before a base indicator (like -0xFF).
 std::ostream &operator <<(std::ostream &os, const BigInteger &x);
 
+/* Hashes for std::unordered_map and friends, from hashValue.  Hashing the
+ * blocks directly is much faster than hashing a decimal string, which takes
+ * time quadratic in the length to produce. */
+namespace std {
+	template <>
+	struct hash<BigUnsigned> {
+		size_t operator ()(const BigUnsigned &x) const {
+			return size_t(x.hashValue());
+		}
+	};
+	template <>
+	struct hash<BigInteger> {
+		size_t operator ()(const BigInteger &x) const {
+			return size_t(x.hashValue());
+		}
+	};
+}
+
 // BEGIN TEMPLATE DEFINITIONS.
 
 /*
@@ -5,19 +5,57 @@
 // The templates used by these constructors and converters are at the bottom of
 // BigUnsigned.hh.
 
-BigUnsigned::BigUnsigned(unsigned long  x) { initFromPrimitive      (x); }
-BigUnsigned::BigUnsigned(unsigned int   x) { initFromPrimitive      (x); }
-BigUnsigned::BigUnsigned(unsigned short x) { initFromPrimitive      (x); }
-BigUnsigned::BigUnsigned(         long  x) { initFromSignedPrimitive(x); }
-BigUnsigned::BigUnsigned(         int   x) { initFromSignedPrimitive(x); }
-BigUnsigned::BigUnsigned(         short x) { initFromSignedPrimitive(x); }
-
-unsigned long  BigUnsigned::toUnsignedLong () const { return convertToPrimitive      <unsigned long >(); }
-unsigned int   BigUnsigned::toUnsignedInt  () const { return convertToPrimitive      <unsigned int  >(); }
-unsigned short BigUnsigned::toUnsignedShort() const { return convertToPrimitive      <unsigned short>(); }
-long           BigUnsigned::toLong         () const { return convertToSignedPrimitive<         long >(); }
-int            BigUnsigned::toInt          () const { return convertToSignedPrimitive<         int  >(); }
-short          BigUnsigned::toShort        () const { return convertToSignedPrimitive<         short>(); }
+// blk is NULL when these run; no need to delete it.
+void BigUnsigned::initFromOperand(const PrimitiveOperand &p) {
+	if (p.negative)
+		throw "BigUnsigned constructor: "
+			"Cannot construct a BigUnsigned from a negative number";
+	if (p.len > 0) {
+		cap = len = p.len;
+		blk = new Blk[cap];
+		for (Index i = 0; i < len; i++)
+			blk[i] = p.blk[i];
+	}
+}
+
+BigUnsigned::BigUnsigned(unsigned long long x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(         long long x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(unsigned long      x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(         long      x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(unsigned int       x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(         int       x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(unsigned short     x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned(         short     x) { initFromPrimitive(x); }
+#ifdef __SIZEOF_INT128__
+BigUnsigned::BigUnsigned(UInt128 x) { initFromPrimitive(x); }
+BigUnsigned::BigUnsigned( Int128 x) { initFromPrimitive(x); }
+#endif
+
+unsigned long long BigUnsigned::toUnsignedLongLong() const { return convertToPrimitive<unsigned long long>(); }
+long long          BigUnsigned::toLongLong        () const { return convertToPrimitive<         long long>(); }
+unsigned long      BigUnsigned::toUnsignedLong    () const { return convertToPrimitive<unsigned long     >(); }
+long               BigUnsigned::toLong            () const { return convertToPrimitive<         long     >(); }
+unsigned int       BigUnsigned::toUnsignedInt     () const { return convertToPrimitive<unsigned int      >(); }
+int                BigUnsigned::toInt             () const { return convertToPrimitive<         int      >(); }
+unsigned short     BigUnsigned::toUnsignedShort   () const { return convertToPrimitive<unsigned short    >(); }
+short              BigUnsigned::toShort           () const { return convertToPrimitive<         short    >(); }
+#ifdef __SIZEOF_INT128__
+BigUnsigned::UInt128 BigUnsigned::toUnsignedInt128() const { return convertToPrimitive<UInt128>(); }
+BigUnsigned:: Int128 BigUnsigned::toInt128        () const { return convertToPrimitive< Int128>(); }
+#endif
+
+bool BigUnsigned::fitsInUnsignedLongLong() const { return fitsInPrimitive<unsigned long long>(); }
+bool BigUnsigned::fitsInLongLong        () const { return fitsInPrimitive<         long long>(); }
+bool BigUnsigned::fitsInUnsignedLong    () const { return fitsInPrimitive<unsigned long     >(); }
+bool BigUnsigned::fitsInLong            () const { return fitsInPrimitive<         long     >(); }
+bool BigUnsigned::fitsInUnsignedInt     () const { return fitsInPrimitive<unsigned int      >(); }
+bool BigUnsigned::fitsInInt             () const { return fitsInPrimitive<         int      >(); }
+bool BigUnsigned::fitsInUnsignedShort   () const { return fitsInPrimitive<unsigned short    >(); }
+bool BigUnsigned::fitsInShort           () const { return fitsInPrimitive<         short    >(); }
+#ifdef __SIZEOF_INT128__
+bool BigUnsigned::fitsInUnsignedInt128  () const { return fitsInPrimitive<UInt128>(); }
+bool BigUnsigned::fitsInInt128          () const { return fitsInPrimitive< Int128>(); }
+#endif
 
 // BIT/BLOCK ACCESSORS
 
@@ -47,15 +85,30 @@ void BigUnsigned::setBlock(Index i, Blk newBlock) {
 BigUnsigned::Index BigUnsigned::bitLength() const {
 	if (isZero())
 		return 0;
-	else {
-		Blk leftmostBlock = getBlock(len - 1);
-		Index leftmostBlockLen = 0;
-		while (leftmostBlock != 0) {
-			leftmostBlock >>= 1;
-			leftmostBlockLen++;
-		}
-		return leftmostBlockLen + (len - 1) * N;
-	}
+	else
+		return len * N - blockLeadingZeros(blk[len - 1]);
+}
+
+BigUnsigned::Index BigUnsigned::countTrailingZeros() const {
+	if (isZero())
+		return 0;
+	Index i = 0;
+	while (blk[i] == 0)
+		i++;
+	return i * N + blockTrailingZeros(blk[i]);
+}
+
+BigUnsigned::Index BigUnsigned::lowestSetBit() const {
+	if (isZero())
+		throw "BigUnsigned::lowestSetBit: Zero has no 1 bits";
+	return countTrailingZeros();
+}
+
+BigUnsigned::Index BigUnsigned::popcount() const {
+	Index n = 0;
+	for (Index i = 0; i < len; i++)
+		n += blockPopcount(blk[i]);
+	return n;
 }
 
 void BigUnsigned::setBit(Index bi, bool newBit) {
@@ -65,6 +118,118 @@ void BigUnsigned::setBit(Index bi, bool newBit) {
 	setBlock(blockI, block);
 }
 
+void BigUnsigned::extendTo(Index l) {
+	if (l <= len)
+		return;
+	allocateAndCopy(l);
+	for (Index j = len; j < l; j++)
+		blk[j] = 0;
+	len = l;
+}
+
+namespace {
+	// Returns a block with bits lo through hi - 1 set, for lo < hi <= N.
+	inline BigUnsigned::Blk rangeMask(unsigned int lo, unsigned int hi) {
+		BigUnsigned::Blk ones = ~BigUnsigned::Blk(0);
+		return (ones << lo) & (ones >> (BigUnsigned::N - hi));
+	}
+}
+
+/* The range functions visit the blocks from pos / N through
+ * (pos + count - 1) / N, masking off the bits outside the range in the first
+ * and last ones.  Ranges that run past the end of the number are cut short
+ * first wherever the missing bits are known to be 0. */
+
+BigUnsigned::Blk BigUnsigned::getBits(Index pos, unsigned int count) const {
+	if (count > N)
+		throw "BigUnsigned::getBits: count must be at most N";
+	if (count == 0)
+		return 0;
+	Index i = pos / N;
+	unsigned int s = pos % N;
+	Blk b = getBlock(i) >> s;
+	if (s != 0 && s + count > N)
+		b |= getBlock(i + 1) << (N - s);
+	return b & rangeMask(0, count);
+}
+
+BigUnsigned BigUnsigned::extractBits(Index pos, Index count) const {
+	BigUnsigned ans;
+	Index bits = bitLength();
+	if (pos >= bits || count == 0)
+		return ans;
+	if (count > bits - pos)
+		count = bits - pos;
+	Index blocks = (count + N - 1) / N;
+	ans.allocate(blocks);
+	for (Index k = 0; k < blocks; k++)
+		ans.blk[k] = getBits(pos + k * N, (k + 1 < blocks) ? N : count - k * N);
+	ans.len = blocks;
+	ans.zapLeadingZeros();
+	return ans;
+}
+
+void BigUnsigned::insertBits(Index pos, const BigUnsigned &x, Index count) {
+	if (this == &x) {
+		BigUnsigned copy(x);
+		insertBits(pos, copy, count);
+		return;
+	}
+	clearBitRange(pos, count);
+	// Only the bits of x below its bit length need to be written.
+	Index bits = x.bitLength();
+	if (count > bits)
+		count = bits;
+	if (count == 0)
+		return;
+	extendTo((pos + count - 1) / N + 1);
+	Index i = pos / N;
+	unsigned int s = pos % N;
+	for (Index k = 0; k * N < count; k++, i++) {
+		Blk b = x.getBits(k * N, (count - k * N < N) ? count - k * N : N);
+		blk[i] |= b << s;
+		if (s != 0 && (b >> (N - s)) != 0)
+			blk[i + 1] |= b >> (N - s);
+	}
+	// The top bits written may have been 0.
+	zapLeadingZeros();
+}
+
+void BigUnsigned::setBitRange(Index pos, Index count) {
+	if (count == 0)
+		return;
+	Index first = pos / N, last = (pos + count - 1) / N;
+	extendTo(last + 1);
+	for (Index i = first; i <= last; i++)
+		blk[i] |= rangeMask((i == first) ? pos % N : 0,
+				(i == last) ? (pos + count - 1) % N + 1 : N);
+}
+
+void BigUnsigned::clearBitRange(Index pos, Index count) {
+	if (count == 0 || pos / N >= len)
+		return;
+	if (count > len * N - pos)
+		count = len * N - pos;
+	Index first = pos / N, last = (pos + count - 1) / N;
+	for (Index i = first; i <= last; i++)
+		blk[i] &= ~rangeMask((i == first) ? pos % N : 0,
+				(i == last) ? (pos + count - 1) % N + 1 : N);
+	zapLeadingZeros();
+}
+
+bool BigUnsigned::testAnyInRange(Index pos, Index count) const {
+	if (count == 0 || pos / N >= len)
+		return false;
+	if (count > len * N - pos)
+		count = len * N - pos;
+	Index first = pos / N, last = (pos + count - 1) / N;
+	for (Index i = first; i <= last; i++)
+		if ((blk[i] & rangeMask((i == first) ? pos % N : 0,
+				(i == last) ? (pos + count - 1) % N + 1 : N)) != 0)
+			return true;
+	return false;
+}
+
 // COMPARISON
 BigUnsigned::CmpRes BigUnsigned::compareTo(const BigUnsigned &x) const {
 	// A bigger length implies a bigger number.
@@ -249,27 +414,23 @@ void BigUnsigned::subtract(const BigUnsigned &a, const BigUnsigned &b) {
  * I also missed his note that ``[b]y adjusting the word size, if
  * necessary, nearly all computers will have these three operations
  * available'', so I gave up on trying to use algorithms similar to his.
- * A future version of the library might include such algorithms; I
- * would welcome contributions from others for this.
  *
- * I eventually decided to use bit-shifting algorithms.  To multiply `a'
- * and `b', we zero out the result.  Then, for each `1' bit in `a', we
- * shift `b' left the appropriate amount and add it to the result.
- * Similarly, to divide `a' by `b', we shift `b' left varying amounts,
- * repeatedly trying to subtract it from `a'.  When we succeed, we note
- * the fact by setting a bit in the quotient.  While these algorithms
- * have the same O(n^2) time complexity as Knuth's, the ``constant factor''
- * is likely to be larger.
+ * I eventually decided to use bit-shifting algorithms: to multiply, add
+ * `b' shifted left once for each `1' bit of `a'; to divide, shift `b' left
+ * varying amounts, repeatedly trying to subtract it from `a'.  While these
+ * had the same O(n^2) time complexity as Knuth's, the ``constant factor''
+ * was a good deal larger.
  *
- * Because I used these algorithms, which require single-block addition
- * and subtraction rather than single-block multiplication and division,
- * the innermost loops of all four routines are very similar.  Study one
- * of them and all will become clear.
+ * Both now use `b_0' and `c_0' (see multiplyBlocks and divideBlocks
+ * below).  Small products are computed with Knuth's Algorithm M, and large
+ * ones with Karatsuba's method, which replaces one product of size n by
+ * three of size n/2 and so takes time O(n^1.585).  Division uses Knuth's
+ * Algorithm D, which finds each block of the quotient from the leading
+ * blocks of the remainder and divisor.
  */
 
 /*
- * This is a little inline function used by both the multiplication
- * routine and the division routine.
+ * This is a little inline function used by the bit shifts.
  *
  * `getShiftedBlock' returns the `x'th block of `num << y'.
  * `y' may be anything from 0 to N - 1, and `x' may be anything from
@@ -297,6 +458,232 @@ inline BigUnsigned::Blk getShiftedBlock(const BigUnsigned &num,
 	return part1 | part2;
 }
 
+namespace {
+	typedef BigUnsigned::Blk Blk;
+	typedef BigUnsigned::Index Index;
+
+	/* Returns the low block of the double-block product a * b and stores
+	 * the high block in hi.  This is Knuth's `b_0' operation; where the
+	 * compiler offers a double-width type we let it do the work, and
+	 * otherwise we multiply half-blocks. */
+	inline Blk multiplyBlocks(Blk a, Blk b, Blk &hi) {
+#ifdef __SIZEOF_INT128__
+		__extension__ typedef unsigned __int128 DoubleBlk;
+		DoubleBlk p = DoubleBlk(a) * b;
+		hi = Blk(p >> BigUnsigned::N);
+		return Blk(p);
+#else
+		const unsigned int h = BigUnsigned::N / 2;
+		const Blk lowMask = (Blk(1) << h) - 1;
+		Blk a0 = a & lowMask, a1 = a >> h, b0 = b & lowMask, b1 = b >> h;
+		Blk p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+		// Sum the middle terms; the carries land in the high block.
+		Blk mid = (p00 >> h) + (p01 & lowMask) + (p10 & lowMask);
+		hi = p11 + (p01 >> h) + (p10 >> h) + (mid >> h);
+		return (mid << h) | (p00 & lowMask);
+#endif
+	}
+
+	/* Divides the double block (hi, lo) by d, where hi < d and the top bit
+	 * of d is set, and returns the quotient, storing the remainder in r.
+	 * This is Knuth's `c_0' operation; without a double-width type, we run
+	 * Algorithm D with half-blocks as digits (see Warren, ``Hacker's
+	 * Delight'', section 9-4). */
+	inline Blk divideBlocks(Blk hi, Blk lo, Blk d, Blk &r) {
+#ifdef __SIZEOF_INT128__
+		__extension__ typedef unsigned __int128 DoubleBlk;
+		DoubleBlk n = (DoubleBlk(hi) << BigUnsigned::N) | lo;
+		Blk q = Blk(n / d);
+		r = lo - q * d;
+		return q;
+#else
+		const unsigned int h = BigUnsigned::N / 2;
+		const Blk base = Blk(1) << h, lowMask = base - 1;
+		Blk d1 = d >> h, d0 = d & lowMask, l1 = lo >> h, l0 = lo & lowMask;
+		// The high half-block of the quotient
+		Blk q1 = hi / d1, rhat = hi - q1 * d1;
+		while (q1 >= base || q1 * d0 > ((rhat << h) | l1)) {
+			q1--;
+			rhat += d1;
+			if (rhat >= base)
+				break;
+		}
+		Blk mid = (hi << h) + l1 - q1 * d;
+		// The low half-block
+		Blk q0 = mid / d1;
+		rhat = mid - q0 * d1;
+		while (q0 >= base || q0 * d0 > ((rhat << h) | l0)) {
+			q0--;
+			rhat += d1;
+			if (rhat >= base)
+				break;
+		}
+		r = (mid << h) + l0 - q0 * d;
+		return (q1 << h) | q0;
+#endif
+	}
+
+	/* The following work on raw block arrays, least significant block
+	 * first, so that Karatsuba's method can recurse on pieces of its
+	 * operands without copying them into BigUnsigneds. */
+
+	// Adds x[0..xn) into r[0..rn), where xn <= rn, and returns the carry.
+	Blk addInto(Blk *r, Index rn, const Blk *x, Index xn) {
+		Blk carry = 0;
+		Index i;
+		for (i = 0; i < xn; i++) {
+			Blk temp = r[i] + carry;
+			carry = (temp < carry);
+			temp += x[i];
+			carry += (temp < x[i]);
+			r[i] = temp;
+		}
+		for (; carry != 0 && i < rn; i++) {
+			r[i]++;
+			carry = (r[i] == 0);
+		}
+		return carry;
+	}
+
+	// Subtracts x[0..xn) from r[0..rn), where xn <= rn, and returns the borrow.
+	Blk subtractFrom(Blk *r, Index rn, const Blk *x, Index xn) {
+		Blk borrow = 0;
+		Index i;
+		for (i = 0; i < xn; i++) {
+			Blk temp = r[i] - borrow;
+			borrow = (temp > r[i]);
+			borrow += (temp < x[i]);
+			r[i] = temp - x[i];
+		}
+		for (; borrow != 0 && i < rn; i++) {
+			borrow = (r[i] == 0);
+			r[i]--;
+		}
+		return borrow;
+	}
+
+	/* r[0..an+bn) = a[0..an) * b[0..bn) by Knuth's Algorithm M.  r must
+	 * not overlap a or b. */
+	void multiplySchoolbook(Blk *r, const Blk *a, Index an,
+			const Blk *b, Index bn) {
+		Index i, j;
+		for (i = 0; i < an + bn; i++)
+			r[i] = 0;
+		for (i = 0; i < an; i++) {
+			Blk carry = 0, hi, lo;
+			for (j = 0; j < bn; j++) {
+				lo = multiplyBlocks(a[i], b[j], hi);
+				lo += carry;
+				hi += (lo < carry);
+				lo += r[i + j];
+				hi += (lo < r[i + j]);
+				r[i + j] = lo;
+				carry = hi;
+			}
+			r[i + bn] = carry;
+		}
+	}
+
+	// Below this many blocks in the shorter operand, Karatsuba doesn't pay.
+	const Index karatsubaThreshold = 32;
+
+	/* r[0..an+bn) = a[0..an) * b[0..bn), where an >= bn.  r must not
+	 * overlap a or b. */
+	void multiplyKaratsuba(Blk *r, const Blk *a, Index an,
+			const Blk *b, Index bn) {
+		if (bn < karatsubaThreshold) {
+			multiplySchoolbook(r, a, an, b, bn);
+			return;
+		}
+		if (an + 1 >= 2 * bn) {
+			/* Too unbalanced to split evenly: multiply b by pieces of a
+			 * that are bn blocks long and add up the results. */
+			Index i;
+			for (i = 0; i < an + bn; i++)
+				r[i] = 0;
+			Blk *t = new Blk[2 * bn];
+			for (i = 0; i < an; i += bn) {
+				Index pn = (an - i < bn) ? an - i : bn;
+				if (pn == bn)
+					multiplyKaratsuba(t, a + i, bn, b, bn);
+				else
+					multiplyKaratsuba(t, b, bn, a + i, pn);
+				addInto(r + i, an + bn - i, t, pn + bn);
+			}
+			delete [] t;
+			return;
+		}
+		/* Split a = a1 B^h + a0 and b = b1 B^h + b0.  Then
+		 * a*b = a1 b1 B^2h + ((a0 + a1)(b0 + b1) - a0 b0 - a1 b1) B^h + a0 b0.
+		 * Since an < 2bn - 1, both high halves are nonempty. */
+		Index h = (an + 1) / 2, a1n = an - h, b1n = bn - h;
+		multiplyKaratsuba(r, a, h, b, h);
+		multiplyKaratsuba(r + 2 * h, a + h, a1n, b + h, b1n);
+		Blk *sa = new Blk[4 * h + 4], *sb = sa + h + 1, *z1 = sb + h + 1;
+		Index i;
+		for (i = 0; i < h; i++)
+			sa[i] = a[i];
+		sa[h] = addInto(sa, h, a + h, a1n);
+		for (i = 0; i < h; i++)
+			sb[i] = b[i];
+		sb[h] = addInto(sb, h, b + h, b1n);
+		multiplyKaratsuba(z1, sa, h + 1, sb, h + 1);
+		subtractFrom(z1, 2 * h + 2, r, 2 * h);
+		subtractFrom(z1, 2 * h + 2, r + 2 * h, a1n + b1n);
+		// The middle term is less than B^(an+bn-h), so its top is zero.
+		Index z1n = 2 * h + 2;
+		if (z1n > an + bn - h)
+			z1n = an + bn - h;
+		addInto(r + h, an + bn - h, z1, z1n);
+		delete [] sa;
+	}
+}
+
+// HASHING
+
+namespace {
+	/* Odd constants with well-mixed bits, from splitmix64, cut down to a
+	 * block if blocks are narrower than 64 bits */
+	const BigUnsigned::Blk hashK1 = BigUnsigned::Blk(0x9E3779B97F4A7C15ULL),
+		hashK2 = BigUnsigned::Blk(0xBF58476D1CE4E5B9ULL),
+		hashK3 = BigUnsigned::Blk(0x94D049BB133111EBULL);
+	const unsigned int hashShift = BigUnsigned::N / 2;
+
+	/* Takes one block into a lane: the low and high halves of the double
+	 * block product, folded together, so every bit of the operand reaches
+	 * every bit of the result. */
+	inline BigUnsigned::Blk hashStep(BigUnsigned::Blk h, BigUnsigned::Blk x) {
+		BigUnsigned::Blk hi, lo = multiplyBlocks(h ^ x, hashK1, hi);
+		return lo ^ hi;
+	}
+
+	// splitmix64's finalizer, in which every input bit affects every output bit
+	inline BigUnsigned::Blk hashMix(BigUnsigned::Blk h) {
+		h = (h ^ (h >> hashShift)) * hashK2;
+		h = (h ^ (h >> hashShift)) * hashK3;
+		return h ^ (h >> hashShift);
+	}
+}
+
+/* The blocks are dealt round-robin to four lanes with their own chains of
+ * multiplications, which the processor can run side by side (or the compiler
+ * can vectorize), and the lanes and the length are mixed together at the
+ * end. */
+BigUnsigned::Blk BigUnsigned::hashValue(Blk seed) const {
+	Blk h[4] = { seed, seed + hashK1, seed + 2 * hashK1, seed + 3 * hashK1 };
+	Index i = 0;
+	unsigned int j;
+	for (; i + 4 <= len; i += 4)
+		for (j = 0; j < 4; j++)
+			h[j] = hashStep(h[j], blk[i + j]);
+	for (j = 0; i < len; i++, j++)
+		h[j] = hashStep(h[j], blk[i]);
+	Blk r = Blk(len);
+	for (j = 0; j < 4; j++)
+		r = hashMix(r ^ h[j]);
+	return r;
+}
+
 void BigUnsigned::multiply(const BigUnsigned &a, const BigUnsigned &b) {
 	DTRT_ALIASED(this == &a || this == &b, multiply(a, b));
 	// If either a or b is zero, set to zero.
@@ -304,68 +691,211 @@ void BigUnsigned::multiply(const BigUnsigned &a, const BigUnsigned &b) {
 		len = 0;
 		return;
 	}
-	/*
-	 * Overall method:
-	 *
-	 * Set this = 0.
-	 * For each 1-bit of `a' (say the `i2'th bit of block `i'):
-	 *    Add `b << (i blocks and i2 bits)' to *this.
-	 */
-	// Variables for the calculation
-	Index i, j, k;
-	unsigned int i2;
-	Blk temp;
-	bool carryIn, carryOut;
 	// Set preliminary length and make room
 	len = a.len + b.len;
 	allocate(len);
-	// Zero out this object
-	for (i = 0; i < len; i++)
-		blk[i] = 0;
-	// For each block of the first number...
+	if (a.len >= b.len)
+		multiplyKaratsuba(blk, a.blk, a.len, b.blk, b.len);
+	else
+		multiplyKaratsuba(blk, b.blk, b.len, a.blk, a.len);
+	// Zap possible leading zero
+	if (blk[len - 1] == 0)
+		len--;
+}
+
+void BigUnsigned::multiplyBlock(const BigUnsigned &a, Blk b) {
+	if (a.len == 0 || b == 0) {
+		len = 0;
+		return;
+	}
+	/* Each block of a is read before the same block of the result is
+	 * written, so an aliased call is safe as long as growing the array
+	 * keeps the contents. */
+	if (this == &a)
+		allocateAndCopy(a.len + 1);
+	else
+		allocate(a.len + 1);
+	Index i;
+	Blk carry = 0, hi, lo;
 	for (i = 0; i < a.len; i++) {
-		// For each 1-bit of that block...
-		for (i2 = 0; i2 < N; i2++) {
-			if ((a.blk[i] & (Blk(1) << i2)) == 0)
-				continue;
-			/*
-			 * Add b to this, shifted left i blocks and i2 bits.
-			 * j is the index in b, and k = i + j is the index in this.
-			 *
-			 * `getShiftedBlock', a short inline function defined above,
-			 * is now used for the bit handling.  It replaces the more
-			 * complex `bHigh' code, in which each run of the loop dealt
-			 * immediately with the low bits and saved the high bits to
-			 * be picked up next time.  The last run of the loop used to
-			 * leave leftover high bits, which were handled separately.
-			 * Instead, this loop runs an additional time with j == b.len.
-			 * These changes were made on 2005.01.11.
-			 */
-			for (j = 0, k = i, carryIn = false; j <= b.len; j++, k++) {
-				/*
-				 * The body of this loop is very similar to the body of the first loop
-				 * in `add', except that this loop does a `+=' instead of a `+'.
-				 */
-				temp = blk[k] + getShiftedBlock(b, j, i2);
-				carryOut = (temp < blk[k]);
-				if (carryIn) {
-					temp++;
-					carryOut |= (temp == 0);
+		lo = multiplyBlocks(a.blk[i], b, hi);
+		lo += carry;
+		// hi can't overflow: the full product is at most (2^N - 1)^2.
+		carry = hi + (lo < carry);
+		blk[i] = lo;
+	}
+	len = a.len;
+	if (carry != 0)
+		blk[len++] = carry;
+}
+
+/* In the next two, only the carry or borrow travels, and it usually stops in
+ * the first block, so an aliased call touches no more than that. */
+void BigUnsigned::addBlock(const BigUnsigned &a, Blk b) {
+	if (this != &a)
+		operator =(a);
+	Index i;
+	for (i = 0; i < len && b != 0; i++) {
+		blk[i] += b;
+		b = (blk[i] < b);
+	}
+	if (b != 0) {
+		allocateAndCopy(len + 1);
+		blk[len++] = b;
+	}
+}
+
+void BigUnsigned::subtractBlock(const BigUnsigned &a, Blk b) {
+	if (a.compareToBlock(b) == less)
+		throw "BigUnsigned::subtractBlock: "
+			"Negative result in unsigned calculation";
+	if (this != &a)
+		operator =(a);
+	Index i;
+	for (i = 0; b != 0; i++) {
+		Blk temp = blk[i];
+		blk[i] = temp - b;
+		b = (temp < b);
+	}
+	zapLeadingZeros();
+}
+
+namespace {
+	/* Short division repeats one divisor, so instead of a `c_0' operation
+	 * per block (which, even with a double-width type, compiles to a
+	 * library call) we find the reciprocal v = floor((B^2 - 1) / d) - B of
+	 * the normalized divisor once and divide with two multiplications.
+	 * This is Algorithm 4 of Moller and Granlund, ``Improved division by
+	 * invariant integers'' (2011). */
+	inline Blk reciprocalBlock(Blk d) {
+		// B^2 - 1 - B*d is (~d, ~0), and ~d < d since the top bit of d is set.
+		Blk r;
+		return divideBlocks(~d, ~Blk(0), d, r);
+	}
+
+	// Like divideBlocks(hi, lo, d, r), given v = reciprocalBlock(d)
+	inline Blk divideBlocksBy(Blk hi, Blk lo, Blk d, Blk v, Blk &r) {
+		Blk qHi, qLo = multiplyBlocks(v, hi, qHi);
+		// (qHi, qLo) += (hi + 1, lo)
+		qLo += lo;
+		qHi += hi + 1 + (qLo < lo);
+		r = lo - qHi * d;
+		// The estimate is at most one too large or one too small.
+		if (r > qLo) {
+			qHi--;
+			r += d;
+		}
+		if (r >= d) {
+			qHi++;
+			r -= d;
+		}
+		return qHi;
+	}
+}
+
+/* Short division from the top block down.  As in divideWithRemainder, the
+ * divisor is normalized so that its top bit is set; the dividend is shifted
+ * along with it a block at a time by getShiftedBlock, and the remainder is
+ * shifted back at the end.  Block i of the quotient is written only after
+ * blocks i and i - 1 of a are read, so an aliased call is safe. */
+BigUnsigned::Blk BigUnsigned::divideBlock(const BigUnsigned &a, Blk b) {
+	if (b == 0)
+		throw "BigUnsigned::divideBlock: division by zero";
+	if (a.len == 0) {
+		len = 0;
+		return 0;
+	}
+	unsigned int s = blockLeadingZeros(b);
+	Blk d = b << s, v = reciprocalBlock(d);
+	// The block shifted out of the top is less than 2^s <= d.
+	Blk r = getShiftedBlock(a, a.len, s);
+	Index i = a.len;
+	if (this != &a)
+		allocate(a.len);
+	while (i > 0) {
+		i--;
+		blk[i] = divideBlocksBy(r, getShiftedBlock(a, i, s), d, v, r);
+	}
+	len = a.len;
+	zapLeadingZeros();
+	return r >> s;
+}
+
+BigUnsigned::Blk BigUnsigned::remainderBlock(Blk b) const {
+	if (b == 0)
+		throw "BigUnsigned::remainderBlock: division by zero";
+	unsigned int s = blockLeadingZeros(b);
+	Blk d = b << s, v = reciprocalBlock(d);
+	Blk r = getShiftedBlock(*this, len, s);
+	Index i = len;
+	while (i > 0) {
+		i--;
+		divideBlocksBy(r, getShiftedBlock(*this, i, s), d, v, r);
+	}
+	return r >> s;
+}
+
+void BigUnsigned::pow(const BigUnsigned &a, unsigned long exponent) {
+	/* An aliased call moves a's blocks into `base' before *this is
+	 * written, which is cheaper than the usual temporary copy. */
+	BigUnsigned base, temp;
+	const BigUnsigned *b = &a;
+	if (this == &a) {
+		base.swap(*this);
+		b = &base;
+	}
+	if (exponent == 0 || (b->len == 1 && b->blk[0] == 1)) {
+		allocate(1);
+		blk[0] = 1;
+		len = 1;
+		return;
+	}
+	if (b->len == 0) {
+		len = 0;
+		return;
+	}
+	// Take out the factors of 2; they come back as one shift at the end.
+	unsigned long zeros = b->countTrailingZeros(), shift = 0;
+	if (zeros != 0) {
+		// bitShiftLeft takes an int.
+		const unsigned long maxShift = (unsigned int)(-1) >> 1;
+		if (exponent > maxShift / zeros)
+			throw "BigUnsigned::pow: Result too large";
+		shift = zeros * exponent;
+		temp.bitShiftRight(*b, int(zeros));
+		base.swap(temp);
+		b = &base;
+	}
+	if (b->len == 1 && b->blk[0] == 1) {
+		// A power of 2: nothing but the shift.
+		allocate(1);
+		blk[0] = 1;
+		len = 1;
+	} else {
+		/* Left-to-right binary exponentiation.  Each square is written to
+		 * temp and then swapped in, and a single-block base is multiplied
+		 * in place as a word. */
+		unsigned long bit = 1;
+		while (bit <= exponent / 2)
+			bit <<= 1;
+		operator =(*b);
+		for (bit >>= 1; bit != 0; bit >>= 1) {
+			temp.multiply(*this, *this);
+			swap(temp);
+			if ((exponent & bit) != 0) {
+				if (b->len == 1)
+					multiplyBlock(*this, b->blk[0]);
+				else {
+					temp.multiply(*this, *b);
+					swap(temp);
 				}
-				blk[k] = temp;
-				carryIn = carryOut;
-			}
-			// No more extra iteration to deal with `bHigh'.
-			// Roll-over a carry as necessary.
-			for (; carryIn; k++) {
-				blk[k]++;
-				carryIn = (blk[k] == 0);
 			}
 		}
 	}
-	// Zap possible leading zero
-	if (blk[len - 1] == 0)
-		len--;
+	if (shift != 0) {
+		temp.bitShiftLeft(*this, int(shift));
+		swap(temp);
+	}
 }
 
 /*
@@ -421,120 +951,109 @@ void BigUnsigned::divideWithRemainder(const BigUnsigned &b, BigUnsigned &q) {
 	// At this point we know (*this).len >= b.len > 0.  (Whew!)
 
 	/*
-	 * Overall method:
-	 *
-	 * For each appropriate i and i2, decreasing:
-	 *    Subtract (b << (i blocks and i2 bits)) from *this, storing the
-	 *      result in subtractBuf.
-	 *    If the subtraction succeeds with a nonnegative result:
-	 *        Turn on bit i2 of block i of the quotient q.
-	 *        Copy subtractBuf back into *this.
-	 *    Otherwise bit i2 of block i remains off, and *this is unchanged.
-	 * 
-	 * Eventually q will contain the entire quotient, and *this will
-	 * be left with the remainder.
-	 *
-	 * subtractBuf[x] corresponds to blk[x], not blk[x+i], since 2005.01.11.
-	 * But on a single iteration, we don't touch the i lowest blocks of blk
-	 * (and don't use those of subtractBuf) because these blocks are
-	 * unaffected by the subtraction: we are subtracting
-	 * (b << (i blocks and i2 bits)), which ends in at least `i' zero
-	 * blocks. */
-	// Variables for the calculation
-	Index i, j, k;
-	unsigned int i2;
-	Blk temp;
-	bool borrowIn, borrowOut;
-
-	/*
-	 * Make sure we have an extra zero block just past the value.
+	 * Overall method (Knuth's Algorithm D, TAOCP 4.3.1):
 	 *
-	 * When we attempt a subtraction, we might shift `b' so
-	 * its first block begins a few bits left of the dividend,
-	 * and then we'll try to compare these extra bits with
-	 * a nonexistent block to the left of the dividend.  The
-	 * extra zero block ensures sensible behavior; we need
-	 * an extra block in `subtractBuf' for exactly the same reason.
+	 * Shift b and *this left until the top bit of b's leading block is
+	 * set.  Then, for each block j of the quotient, from the most
+	 * significant down:
+	 *    Estimate the quotient block qhat by dividing the top two blocks
+	 *      of the current remainder by b's leading block.  Because b is
+	 *      normalized, the estimate is at most 2 too large, and checking
+	 *      it against b's second block almost always makes it exact.
+	 *    Subtract qhat * (b << j blocks) from *this.
+	 *    If that went negative, qhat was one too large after all: add
+	 *      b back and decrement qhat.
+	 * What is left in *this, shifted back right, is the remainder.
 	 */
-	Index origLen = len; // Save real length.
-	/* To avoid an out-of-bounds access in case of reallocation, allocate
-	 * first and then increment the logical length. */
+	Index n = b.len, m = len - b.len, i, j;
+	// Count the leading zero bits of b's leading block.
+	unsigned int shift = blockLeadingZeros(b.blk[n - 1]);
+	// v is the normalized divisor.
+	Blk *v = new Blk[n];
+	for (i = 0; i < n; i++)
+		v[i] = getShiftedBlock(b, i, shift);
+	/* Normalize *this in place, making room for the extra block.  To avoid
+	 * an out-of-bounds access in case of reallocation, allocate first and
+	 * then increment the logical length. */
 	allocateAndCopy(len + 1);
 	len++;
-	blk[origLen] = 0; // Zero the added block.
-
-	// subtractBuf holds part of the result of a subtraction; see above.
-	Blk *subtractBuf = new Blk[len];
+	blk[len - 1] = 0;
+	if (shift != 0) {
+		for (i = len - 1; i > 0; i--)
+			blk[i] = (blk[i] << shift) | (blk[i - 1] >> (N - shift));
+		blk[0] <<= shift;
+	}
 
-	// Set preliminary length for quotient and make room
-	q.len = origLen - b.len + 1;
+	q.len = m + 1;
 	q.allocate(q.len);
-	// Zero out the quotient
-	for (i = 0; i < q.len; i++)
-		q.blk[i] = 0;
-
-	// For each possible left-shift of b in blocks...
-	i = q.len;
-	while (i > 0) {
-		i--;
-		// For each possible left-shift of b in bits...
-		// (Remember, N is the number of bits in a Blk.)
-		q.blk[i] = 0;
-		i2 = N;
-		while (i2 > 0) {
-			i2--;
-			/*
-			 * Subtract b, shifted left i blocks and i2 bits, from *this,
-			 * and store the answer in subtractBuf.  In the for loop, `k == i + j'.
-			 *
-			 * Compare this to the middle section of `multiply'.  They
-			 * are in many ways analogous.  See especially the discussion
-			 * of `getShiftedBlock'.
-			 */
-			for (j = 0, k = i, borrowIn = false; j <= b.len; j++, k++) {
-				temp = blk[k] - getShiftedBlock(b, j, i2);
-				borrowOut = (temp > blk[k]);
-				if (borrowIn) {
-					borrowOut |= (temp == 0);
-					temp--;
-				}
-				// Since 2005.01.11, indices of `subtractBuf' directly match those of `blk', so use `k'.
-				subtractBuf[k] = temp; 
-				borrowIn = borrowOut;
-			}
-			// No more extra iteration to deal with `bHigh'.
-			// Roll-over a borrow as necessary.
-			for (; k < origLen && borrowIn; k++) {
-				borrowIn = (blk[k] == 0);
-				subtractBuf[k] = blk[k] - 1;
+	j = m + 1;
+	while (j > 0) {
+		j--;
+		// Estimate the quotient block from the top of the remainder.
+		Blk qhat, rhat;
+		bool rhatOverflow;
+		if (blk[j + n] == v[n - 1]) {
+			// The estimate would not fit in a block; b - 1 is enough.
+			qhat = ~Blk(0);
+			rhat = blk[j + n - 1] + v[n - 1];
+			rhatOverflow = (rhat < v[n - 1]);
+		} else {
+			qhat = divideBlocks(blk[j + n], blk[j + n - 1], v[n - 1], rhat);
+			rhatOverflow = false;
+		}
+		// Refine it using the second block of b.
+		while (n >= 2 && !rhatOverflow) {
+			Blk hi, lo = multiplyBlocks(qhat, v[n - 2], hi);
+			if (hi < rhat || (hi == rhat && lo <= blk[j + n - 2]))
+				break;
+			qhat--;
+			rhat += v[n - 1];
+			rhatOverflow = (rhat < v[n - 1]);
+		}
+		// Subtract qhat * v from blocks j through j + n of the remainder.
+		Blk carry = 0;
+		for (i = 0; i < n; i++) {
+			Blk hi, lo = multiplyBlocks(qhat, v[i], hi);
+			lo += carry;
+			if (lo < carry)
+				hi++;
+			carry = hi;
+			Blk t = blk[i + j] - lo;
+			if (t > blk[i + j])
+				carry++;
+			blk[i + j] = t;
+		}
+		bool negative = (carry > blk[j + n]);
+		blk[j + n] -= carry;
+		// If the result went negative, add v back.
+		if (negative) {
+			qhat--;
+			carry = 0;
+			for (i = 0; i < n; i++) {
+				Blk t = blk[i + j] + v[i];
+				Blk c = (t < v[i]);
+				t += carry;
+				c |= (t < carry);
+				blk[i + j] = t;
+				carry = c;
 			}
-			/*
-			 * If the subtraction was performed successfully (!borrowIn),
-			 * set bit i2 in block i of the quotient.
-			 *
-			 * Then, copy the portion of subtractBuf filled by the subtraction
-			 * back to *this.  This portion starts with block i and ends--
-			 * where?  Not necessarily at block `i + b.len'!  Well, we
-			 * increased k every time we saved a block into subtractBuf, so
-			 * the region of subtractBuf we copy is just [i, k).
-			 */
-			if (!borrowIn) {
-				q.blk[i] |= (Blk(1) << i2);
-				while (k > i) {
-					k--;
-					blk[k] = subtractBuf[k];
-				}
-			} 
+			blk[j + n] += carry;
 		}
+		q.blk[j] = qhat;
 	}
+	delete [] v;
 	// Zap possible leading zero in quotient
 	if (q.blk[q.len - 1] == 0)
 		q.len--;
+	// Unnormalize the remainder, which is in the low n blocks.
+	len = n;
+	if (shift != 0) {
+		for (i = 0; i + 1 < n; i++)
+			blk[i] = (blk[i] >> shift) | (blk[i + 1] << (N - shift));
+		blk[n - 1] >>= shift;
+	}
 	// Zap any/all leading zeros in remainder
 	zapLeadingZeros();
-	// Deallocate subtractBuf.
-	// (Thanks to Brad Spencer for noticing my accidental omission of this!)
-	delete [] subtractBuf;
 }
 
 /* BITWISE OPERATORS
@@ -592,6 +1111,58 @@ void BigUnsigned::bitXor(const BigUnsigned &a, const BigUnsigned &b) {
 	zapLeadingZeros();
 }
 
+namespace {
+	inline BigUnsigned::Blk bitwise(char op, BigUnsigned::Blk x,
+			BigUnsigned::Blk y) {
+		return (op == '&') ? (x & y) : (op == '|') ? (x | y) : (x ^ y);
+	}
+}
+
+bool BigUnsigned::bitwiseTwosComplement(const BigUnsigned &a, bool aNegative,
+		const BigUnsigned &b, bool bNegative, char op) {
+	if (this == &a || this == &b) {
+		BigUnsigned tmpThis;
+		bool negative = tmpThis.bitwiseTwosComplement(a, aNegative,
+				b, bNegative, op);
+		*this = tmpThis;
+		return negative;
+	}
+	// The blocks beyond both operands are all copies of this one.
+	Blk fill = bitwise(op, aNegative ? ~Blk(0) : 0, bNegative ? ~Blk(0) : 0);
+	bool negative = (fill != 0);
+	Index n = (a.len >= b.len) ? a.len : b.len;
+	// + 1: room for the carry when a negative result is negated back
+	allocate(n + 1);
+	/* The borrows of the subtractions m - 1 for the negative operands, and
+	 * the carry of the negation ~r + 1 for a negative result */
+	Blk aBorrow = aNegative ? 1 : 0, bBorrow = bNegative ? 1 : 0;
+	Blk carry = negative ? 1 : 0;
+	for (Index i = 0; i < n; i++) {
+		Blk x = a.getBlock(i), y = b.getBlock(i), t;
+		if (aNegative) {
+			t = x - aBorrow;
+			aBorrow = (x < aBorrow);
+			x = ~t;
+		}
+		if (bNegative) {
+			t = y - bBorrow;
+			bBorrow = (y < bBorrow);
+			y = ~t;
+		}
+		Blk r = bitwise(op, x, y);
+		if (negative) {
+			r = ~r + carry;
+			carry = (r < carry);
+		}
+		blk[i] = r;
+	}
+	len = n;
+	if (negative && carry != 0)
+		blk[len++] = carry;
+	zapLeadingZeros();
+	return negative;
+}
+
 void BigUnsigned::bitShiftLeft(const BigUnsigned &a, int b) {
 	DTRT_ALIASED(this == &a, bitShiftLeft(a, b));
 	if (b < 0) {
@@ -603,6 +1174,11 @@ void BigUnsigned::bitShiftLeft(const BigUnsigned &a, int b) {
 			return;
 		}
 	}
+	// Zero would otherwise come out as shiftBlocks zero blocks.
+	if (a.len == 0) {
+		len = 0;
+		return;
+	}
 	Index shiftBlocks = b / N;
 	unsigned int shiftBits = b % N;
 	// + 1: room for high bits nudged left into another block
@@ -653,6 +1229,74 @@ void BigUnsigned::bitShiftRight(const BigUnsigned &a, int b) {
 		len--;
 }
 
+// MIXED-TYPE OPERATORS
+
+namespace {
+	void checkNonnegative(const PrimitiveOperand &b) {
+		if (b.negative)
+			throw "BigUnsigned: Cannot operate on a negative number";
+	}
+}
+
+void BigUnsigned::addPrimitive(const BigUnsigned &a,
+		const PrimitiveOperand &b) {
+	checkNonnegative(b);
+	if (b.fitsInBlock())
+		addBlock(a, b.getBlock());
+	else
+		add(a, b.getMagnitude());
+}
+
+void BigUnsigned::subtractPrimitive(const BigUnsigned &a,
+		const PrimitiveOperand &b) {
+	checkNonnegative(b);
+	if (b.fitsInBlock())
+		subtractBlock(a, b.getBlock());
+	else
+		subtract(a, b.getMagnitude());
+}
+
+void BigUnsigned::multiplyPrimitive(const BigUnsigned &a,
+		const PrimitiveOperand &b) {
+	checkNonnegative(b);
+	if (b.fitsInBlock())
+		multiplyBlock(a, b.getBlock());
+	else
+		multiply(a, b.getMagnitude());
+}
+
+void BigUnsigned::dividePrimitive(const BigUnsigned &a,
+		const PrimitiveOperand &b) {
+	checkNonnegative(b);
+	if (b.fitsInBlock())
+		divideBlock(a, b.getBlock());
+	else {
+		BigUnsigned r(a);
+		r.divideWithRemainder(b.getMagnitude(), *this);
+	}
+}
+
+void BigUnsigned::moduloPrimitive(const BigUnsigned &a,
+		const PrimitiveOperand &b) {
+	checkNonnegative(b);
+	if (b.fitsInBlock()) {
+		Blk r = a.remainderBlock(b.getBlock());
+		len = 0;
+		setBlock(0, r);
+	} else {
+		BigUnsigned q;
+		operator =(a);
+		divideWithRemainder(b.getMagnitude(), q);
+	}
+}
+
+BigUnsigned::CmpRes BigUnsigned::comparePrimitive(
+		const PrimitiveOperand &b) const {
+	checkNonnegative(b);
+	return b.fitsInBlock() ? compareToBlock(b.getBlock())
+		: compareTo(b.getMagnitude());
+}
+
 // INCREMENT/DECREMENT OPERATORS
 
 // Prefix increment
@@ -3,6 +3,14 @@
 
 #include "NumberlikeArray.hh"
 
+/* IfPrimitive<X, R>::Type is R when X is one of the primitive integer types
+ * accepted by the mixed-type operators, and doesn't exist otherwise, which
+ * takes those operator templates out of overload resolution for any other X.
+ * The specializations follow the BigUnsigned class. */
+template <class X, class R> struct IfPrimitive {};
+
+class PrimitiveOperand;
+
 /* A BigUnsigned object represents a nonnegative integer of size limited only by
  * available memory.  BigUnsigneds support most mathematical operators and can
  * be converted to and from most primitive integer types.
@@ -22,6 +30,16 @@ public:
 	typedef NumberlikeArray<Blk>::Index Index;
     using NumberlikeArray<Blk>::N;
 
+#ifdef __SIZEOF_INT128__
+	// The compiler's 128-bit integer types, under names -pedantic accepts
+	__extension__ typedef          __int128  Int128;
+	__extension__ typedef unsigned __int128 UInt128;
+	// The widest unsigned primitive type, which conversions go through
+	typedef UInt128 WidestUnsigned;
+#else
+	typedef unsigned long long WidestUnsigned;
+#endif
+
 protected:
 	// Creates a BigUnsigned with a capacity; for internal use.
 	BigUnsigned(int, Index c) : NumberlikeArray<Blk>(0, c) {}
@@ -32,6 +50,9 @@ protected:
 			len--;
 	}
 
+	// Increases len to at least l, filling in zero blocks.
+	void extendTo(Index l);
+
 public:
 	// Constructs zero.
 	BigUnsigned() : NumberlikeArray<Blk>() {}
@@ -44,6 +65,9 @@ public:
 		NumberlikeArray<Blk>::operator =(x);
 	}
 
+	// Exchanges the values of *this and x without copying any blocks.
+	void swap(BigUnsigned &x) { NumberlikeArray<Blk>::swap(x); }
+
 	// Constructor that copies from a given array of blocks.
 	BigUnsigned(const Blk *b, Index blen) : NumberlikeArray<Blk>(b, blen) {
 		// Eliminate any leading zeros we may have been passed.
@@ -54,31 +78,60 @@ public:
 	~BigUnsigned() {}
 	
 	// Constructors from primitive integer types
-	BigUnsigned(unsigned long  x);
-	BigUnsigned(         long  x);
-	BigUnsigned(unsigned int   x);
-	BigUnsigned(         int   x);
-	BigUnsigned(unsigned short x);
-	BigUnsigned(         short x);
+	BigUnsigned(unsigned long long x);
+	BigUnsigned(         long long x);
+	BigUnsigned(unsigned long      x);
+	BigUnsigned(         long      x);
+	BigUnsigned(unsigned int       x);
+	BigUnsigned(         int       x);
+	BigUnsigned(unsigned short     x);
+	BigUnsigned(         short     x);
+#ifdef __SIZEOF_INT128__
+	BigUnsigned(UInt128 x);
+	BigUnsigned( Int128 x);
+#endif
 protected:
 	// Helpers
-	template <class X> void initFromPrimitive      (X x);
-	template <class X> void initFromSignedPrimitive(X x);
+	template <class X> void initFromPrimitive(X x);
+	void initFromOperand(const PrimitiveOperand &p);
 public:
 
 	/* Converters to primitive integer types
 	 * The implicit conversion operators caused trouble, so these are now
-	 * named. */
-	unsigned long  toUnsignedLong () const;
-	long           toLong         () const;
-	unsigned int   toUnsignedInt  () const;
-	int            toInt          () const;
-	unsigned short toUnsignedShort() const;
-	short          toShort        () const;
+	 * named.  They throw an exception if the value doesn't fit; the
+	 * fitsIn methods say in advance whether it does. */
+	unsigned long long toUnsignedLongLong() const;
+	long long          toLongLong        () const;
+	unsigned long      toUnsignedLong    () const;
+	long               toLong            () const;
+	unsigned int       toUnsignedInt     () const;
+	int                toInt             () const;
+	unsigned short     toUnsignedShort   () const;
+	short              toShort           () const;
+#ifdef __SIZEOF_INT128__
+	UInt128            toUnsignedInt128  () const;
+	Int128             toInt128          () const;
+#endif
+
+	bool fitsInUnsignedLongLong() const;
+	bool fitsInLongLong        () const;
+	bool fitsInUnsignedLong    () const;
+	bool fitsInLong            () const;
+	bool fitsInUnsignedInt     () const;
+	bool fitsInInt             () const;
+	bool fitsInUnsignedShort   () const;
+	bool fitsInShort           () const;
+#ifdef __SIZEOF_INT128__
+	bool fitsInUnsignedInt128  () const;
+	bool fitsInInt128          () const;
+#endif
 protected:
 	// Helpers
-	template <class X> X convertToSignedPrimitive() const;
-	template <class X> X convertToPrimitive      () const;
+	template <class X> bool fitsInPrimitive() const;
+	template <class X> X convertToPrimitive() const;
+	/* Returns the number modulo 2^(bits in WidestUnsigned), put together
+	 * from its low blocks. */
+	WidestUnsigned lowBits() const;
 public:
 
 	// BIT/BLOCK ACCESSORS
@@ -109,10 +162,45 @@ public:
 	 * necessary. */
 	void setBit(Index bi, bool newBit);
 
+	/* Bit ranges.  The range of count bits starting at bit pos covers bits
+	 * pos through pos + count - 1, and these all work a block at a time.
+	 * getBits returns the range as a block, so count must be at most N;
+	 * extractBits returns a range of any length as a number. */
+	Blk getBits(Index pos, unsigned int count) const;
+	BigUnsigned extractBits(Index pos, Index count) const;
+	// Replaces the range with the low count bits of x.
+	void insertBits(Index pos, const BigUnsigned &x, Index count);
+	// Sets every bit in the range to 1 or to 0, respectively.
+	void setBitRange(Index pos, Index count);
+	void clearBitRange(Index pos, Index count);
+	// Returns true if any bit in the range is 1.
+	bool testAnyInRange(Index pos, Index count) const;
+
+	/* Returns the number of 0 bits below the lowest 1 bit, or 0 if the
+	 * number is zero. */
+	Index countTrailingZeros() const;
+	/* Returns the position of the lowest 1 bit, the largest bi such that
+	 * the number is a multiple of 2^bi.  Throws an exception for zero. */
+	Index lowestSetBit() const;
+	// Returns the number of 1 bits.
+	Index popcount() const;
+
+	/* The same scans on a single block, using the compiler's bit-scanning
+	 * builtins where available.  The block must be nonzero for the first
+	 * two. */
+	static unsigned int blockLeadingZeros(Blk b);
+	static unsigned int blockTrailingZeros(Blk b);
+	static unsigned int blockPopcount(Blk b);
+
 	// COMPARISONS
 
 	// Compares this to x like Perl's <=>
 	CmpRes compareTo(const BigUnsigned &x) const;
+	// Compares this to a single block b
+	CmpRes compareToBlock(Blk b) const {
+		Blk x = getBlock(0);
+		return (len > 1 || x > b) ? greater : (x == b) ? equal : less;
+	}
 
 	// Ordinary comparison operators
 	bool operator ==(const BigUnsigned &x) const {
@@ -126,6 +214,12 @@ public:
 	bool operator >=(const BigUnsigned &x) const { return compareTo(x) != less   ; }
 	bool operator > (const BigUnsigned &x) const { return compareTo(x) == greater; }
 
+	/* Returns a hash of the number for unordered containers (see the
+	 * std::hash specializations in BigIntegerUtils.hh), in time linear in
+	 * its length.  Equal numbers hash equally for equal seeds.  This is
+	 * not meant to stand up to inputs chosen to collide. */
+	Blk hashValue(Blk seed = 0) const;
+
 	/*
 	 * BigUnsigned and BigInteger both provide three kinds of operators.
 	 * Here ``big-integer'' refers to BigInteger or BigUnsigned.
@@ -186,6 +280,26 @@ public:
 	void bitShiftLeft(const BigUnsigned &a, int b);
 	void bitShiftRight(const BigUnsigned &a, int b);
 
+	/* Like `multiply', but with a single-block second operand, which is
+	 * multiplied in one pass without constructing a BigUnsigned for it. */
+	void multiplyBlock(const BigUnsigned &a, Blk b);
+
+	/* The other single-block operations.  These work in place when a is
+	 * *this, so that `x += 1' only allocates when x grows by a block.
+	 * divideBlock sets *this to a / b and returns a % b, and
+	 * remainderBlock returns *this % b without writing anything; both
+	 * throw an exception if b is zero. */
+	void addBlock(const BigUnsigned &a, Blk b);
+	void subtractBlock(const BigUnsigned &a, Blk b);
+	Blk divideBlock(const BigUnsigned &a, Blk b);
+	Blk remainderBlock(Blk b) const;
+
+	/* Sets *this to a ^ exponent (with 0 ^ 0 == 1).  Factors of 2 in a are
+	 * applied as one shift at the end, a single-block base is multiplied in
+	 * with multiplyBlock, and the squarings alternate between two buffers,
+	 * so no intermediate result is copied. */
+	void pow(const BigUnsigned &a, unsigned long exponent);
+
 	/* `a.divideWithRemainder(b, q)' is like `q = a / b, a %= b'.
 	 * / and % use semantics similar to Knuth's, which differ from the
 	 * primitive integer semantics under division by zero.  See the
@@ -223,6 +337,42 @@ public:
 	void operator <<=(int b);
 	void operator >>=(int b);
 
+	/* MIXED-TYPE OPERATORS
+	 * The arithmetic, comparison and assignment operators also take the
+	 * primitive integer types from short to __int128 directly.  An operand
+	 * that fits in a block goes to the single-block operations above, so
+	 * `x += 1', `x * 10' and `x < 0' construct no temporary BigUnsigned;
+	 * wider ones go through the usual path.  As with the constructors, a
+	 * negative operand throws an exception. */
+	template <class X> typename IfPrimitive<X, BigUnsigned>::Type operator +(X x) const;
+	template <class X> typename IfPrimitive<X, BigUnsigned>::Type operator -(X x) const;
+	template <class X> typename IfPrimitive<X, BigUnsigned>::Type operator *(X x) const;
+	template <class X> typename IfPrimitive<X, BigUnsigned>::Type operator /(X x) const;
+	template <class X> typename IfPrimitive<X, BigUnsigned>::Type operator %(X x) const;
+
+	template <class X> typename IfPrimitive<X, bool>::Type operator ==(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator !=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator < (X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator <=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator >=(X x) const;
+	template <class X> typename IfPrimitive<X, bool>::Type operator > (X x) const;
+
+	template <class X> typename IfPrimitive<X, void>::Type operator +=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator -=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator *=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator /=(X x);
+	template <class X> typename IfPrimitive<X, void>::Type operator %=(X x);
+
+protected:
+	// Helpers for the above, which pick a kernel for the operand's size
+	void addPrimitive     (const BigUnsigned &a, const PrimitiveOperand &b);
+	void subtractPrimitive(const BigUnsigned &a, const PrimitiveOperand &b);
+	void multiplyPrimitive(const BigUnsigned &a, const PrimitiveOperand &b);
+	void dividePrimitive  (const BigUnsigned &a, const PrimitiveOperand &b);
+	void moduloPrimitive  (const BigUnsigned &a, const PrimitiveOperand &b);
+	CmpRes comparePrimitive(const PrimitiveOperand &b) const;
+public:
+
 	/* INCREMENT/DECREMENT OPERATORS
 	 * To discourage messy coding, these do not return *this, so prefix
 	 * and postfix behave the same. */
@@ -235,9 +385,16 @@ public:
 	friend Blk getShiftedBlock(const BigUnsigned &num, Index x,
 			unsigned int y);
 
-	// See BigInteger.cc.
-	template <class X>
-	friend X convertBigUnsignedToPrimitiveAccess(const BigUnsigned &a);
+protected:
+	/* Kernel of BigInteger's bitwise operators.  Applies op ('&', '|' or
+	 * '^') to a and b, each standing for the infinite two's complement of
+	 * its negative if aNegative (or bNegative) is set, stores the magnitude
+	 * of the result in *this and returns whether the result is negative.
+	 * The complement of a magnitude m is ~(m - 1), and its blocks are
+	 * produced one at a time as the loop reaches them. */
+	bool bitwiseTwosComplement(const BigUnsigned &a, bool aNegative,
+			const BigUnsigned &b, bool bNegative, char op);
+	friend class BigInteger;
 };
 
 /* Implementing the return-by-value and assignment operators in terms of the
@@ -339,80 +496,220 @@ inline void BigUnsigned::operator >>=(int b) {
 	bitShiftRight(*this, b);
 }
 
+// MIXED-TYPE OPERATORS
+
+template <class R> struct IfPrimitive<         short    , R> { typedef R Type; static const bool isSigned = true ; };
+template <class R> struct IfPrimitive<unsigned short    , R> { typedef R Type; static const bool isSigned = false; };
+template <class R> struct IfPrimitive<         int      , R> { typedef R Type; static const bool isSigned = true ; };
+template <class R> struct IfPrimitive<unsigned int      , R> { typedef R Type; static const bool isSigned = false; };
+template <class R> struct IfPrimitive<         long     , R> { typedef R Type; static const bool isSigned = true ; };
+template <class R> struct IfPrimitive<unsigned long     , R> { typedef R Type; static const bool isSigned = false; };
+template <class R> struct IfPrimitive<         long long, R> { typedef R Type; static const bool isSigned = true ; };
+template <class R> struct IfPrimitive<unsigned long long, R> { typedef R Type; static const bool isSigned = false; };
+#ifdef __SIZEOF_INT128__
+template <class R> struct IfPrimitive<BigUnsigned:: Int128, R> { typedef R Type; static const bool isSigned = true ; };
+template <class R> struct IfPrimitive<BigUnsigned::UInt128, R> { typedef R Type; static const bool isSigned = false; };
+#endif
+
+/* A primitive integer operand split into a sign and the blocks of its
+ * magnitude, held in the object itself so that nothing is allocated. */
+class PrimitiveOperand {
+public:
+	typedef BigUnsigned::Blk Blk;
+	typedef BigUnsigned::Index Index;
+	// The widest primitive type, which every operand is converted to
+	typedef BigUnsigned::WidestUnsigned Wide;
+
+	bool negative;
+	// The magnitude is blk[0..len), least significant block first.
+	Index len;
+	Blk blk[sizeof(Wide) / sizeof(Blk)];
+
+	template <class X> explicit PrimitiveOperand(X x);
+
+	bool isZero() const { return len == 0; }
+	bool fitsInBlock() const { return len <= 1; }
+	Blk getBlock() const { return len == 0 ? 0 : blk[0]; }
+	BigUnsigned getMagnitude() const { return BigUnsigned(blk, len); }
+};
+
+/* Converting a negative x to Wide sign-extends it, so negating the result
+ * gives the magnitude, even of the most negative X.  Testing the top bit
+ * instead of x < 0 avoids g++'s warning about a comparison that is always
+ * false for unsigned X. */
+template <class X>
+PrimitiveOperand::PrimitiveOperand(X x) : len(0) {
+	Wide w = Wide(x);
+	negative = IfPrimitive<X, void>::isSigned
+		&& (w >> (8 * sizeof(Wide) - 1)) != 0;
+	if (negative)
+		w = Wide(0) - w;
+	for (; w != 0; len++) {
+		blk[len] = Blk(w);
+		// In two steps, in case Wide is no wider than a block
+		w = (w >> (BigUnsigned::N - 1)) >> 1;
+	}
+}
+
+template <class X>
+inline typename IfPrimitive<X, BigUnsigned>::Type BigUnsigned::operator +(X x) const {
+	BigUnsigned ans;
+	ans.addPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigUnsigned>::Type BigUnsigned::operator -(X x) const {
+	BigUnsigned ans;
+	ans.subtractPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigUnsigned>::Type BigUnsigned::operator *(X x) const {
+	BigUnsigned ans;
+	ans.multiplyPrimitive(*this, PrimitiveOperand(x));
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigUnsigned>::Type BigUnsigned::operator /(X x) const {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigUnsigned::operator /: division by zero";
+	BigUnsigned ans;
+	ans.dividePrimitive(*this, y);
+	return ans;
+}
+template <class X>
+inline typename IfPrimitive<X, BigUnsigned>::Type BigUnsigned::operator %(X x) const {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigUnsigned::operator %: division by zero";
+	BigUnsigned ans;
+	ans.moduloPrimitive(*this, y);
+	return ans;
+}
+
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator ==(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == equal;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator !=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != equal;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator < (X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == less;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator <=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != greater;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator >=(X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) != less;
+}
+template <class X>
+inline typename IfPrimitive<X, bool>::Type BigUnsigned::operator > (X x) const {
+	return comparePrimitive(PrimitiveOperand(x)) == greater;
+}
+
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigUnsigned::operator +=(X x) {
+	addPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigUnsigned::operator -=(X x) {
+	subtractPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigUnsigned::operator *=(X x) {
+	multiplyPrimitive(*this, PrimitiveOperand(x));
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigUnsigned::operator /=(X x) {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigUnsigned::operator /=: division by zero";
+	dividePrimitive(*this, y);
+}
+template <class X>
+inline typename IfPrimitive<X, void>::Type BigUnsigned::operator %=(X x) {
+	PrimitiveOperand y(x);
+	if (y.isZero()) throw "BigUnsigned::operator %=: division by zero";
+	moduloPrimitive(*this, y);
+}
+
 /* Templates for conversions of BigUnsigned to and from primitive integers.
- * BigInteger.cc needs to instantiate convertToPrimitive, and the uses in
- * BigUnsigned.cc didn't do the trick; I think g++ inlined convertToPrimitive
- * instead of generating linkable instantiations.  So for consistency, I put
- * all the templates here. */
+ * They go through PrimitiveOperand and WidestUnsigned, so one version of each
+ * serves every type from short to __int128, whatever the block size. */
 
 // CONSTRUCTION FROM PRIMITIVE INTEGERS
 
-/* Initialize this BigUnsigned from the given primitive integer.  The same
- * pattern works for all primitive integer types, so I put it into a template to
- * reduce code duplication.  (Don't worry: this is protected and we instantiate
- * it only with primitive integer types.)  Type X could be signed, but x is
- * known to be nonnegative. */
+/* Initialize this BigUnsigned from the given primitive integer.  (This is
+ * protected and we instantiate it only with primitive integer types.) */
 template <class X>
 void BigUnsigned::initFromPrimitive(X x) {
-	if (x == 0)
-		; // NumberlikeArray already initialized us to zero.
-	else {
-		// Create a single block.  blk is NULL; no need to delete it.
-		cap = 1;
-		blk = new Blk[1];
-		len = 1;
-		blk[0] = Blk(x);
-	}
+	initFromOperand(PrimitiveOperand(x));
 }
 
-/* Ditto, but first check that x is nonnegative.  I could have put the check in
- * initFromPrimitive and let the compiler optimize it out for unsigned-type
- * instantiations, but I wanted to avoid the warning stupidly issued by g++ for
- * a condition that is constant in *any* instantiation, even if not in all. */
-template <class X>
-void BigUnsigned::initFromSignedPrimitive(X x) {
-	if (x < 0)
-		throw "BigUnsigned constructor: "
-			"Cannot construct a BigUnsigned from a negative number";
-	else
-		initFromPrimitive(x);
+// BIT SCANS OF A BLOCK
+
+#ifdef __GNUC__
+inline unsigned int BigUnsigned::blockLeadingZeros(Blk b) {
+	return __builtin_clzl(b);
+}
+inline unsigned int BigUnsigned::blockTrailingZeros(Blk b) {
+	return __builtin_ctzl(b);
 }
+inline unsigned int BigUnsigned::blockPopcount(Blk b) {
+	return __builtin_popcountl(b);
+}
+#else
+inline unsigned int BigUnsigned::blockLeadingZeros(Blk b) {
+	unsigned int n = 0;
+	for (; (b >> (N - 1)) == 0; b <<= 1)
+		n++;
+	return n;
+}
+inline unsigned int BigUnsigned::blockTrailingZeros(Blk b) {
+	unsigned int n = 0;
+	for (; (b & 1) == 0; b >>= 1)
+		n++;
+	return n;
+}
+inline unsigned int BigUnsigned::blockPopcount(Blk b) {
+	unsigned int n = 0;
+	// Each step clears the lowest 1 bit.
+	for (; b != 0; b &= b - 1)
+		n++;
+	return n;
+}
+#endif
 
 // CONVERSION TO PRIMITIVE INTEGERS
 
-/* Template with the same idea as initFromPrimitive.  This might be slightly
- * slower than the previous version with the masks, but it's much shorter and
- * clearer, which is the library's stated goal. */
+/* Rather than converting and checking that the value survived the round trip,
+ * these compare the bit length with the value bits of X: all of them, less
+ * the sign bit if X is signed. */
+template <class X>
+bool BigUnsigned::fitsInPrimitive() const {
+	return bitLength() <= 8 * sizeof(X) - IfPrimitive<X, void>::isSigned;
+}
+
 template <class X>
 X BigUnsigned::convertToPrimitive() const {
-	if (len == 0)
-		// The number is zero; return zero.
-		return 0;
-	else if (len == 1) {
-		// The single block might fit in an X.  Try the conversion.
-		X x = X(blk[0]);
-		// Make sure the result accurately represents the block.
-		if (Blk(x) == blk[0])
-			// Successful conversion.
-			return x;
-		// Otherwise fall through.
-	}
+	if (fitsInPrimitive<X>())
+		return X(lowBits());
 	throw "BigUnsigned::to<Primitive>: "
 		"Value is too big to fit in the requested type";
 }
 
-/* Wrap the above in an x >= 0 test to make sure we got a nonnegative result,
- * not a negative one that happened to convert back into the correct nonnegative
- * one.  (E.g., catch incorrect conversion of 2^31 to the long -2^31.)  Again,
- * separated to avoid a g++ warning. */
-template <class X>
-X BigUnsigned::convertToSignedPrimitive() const {
-	X x = convertToPrimitive<X>();
-	if (x >= 0)
-		return x;
-	else
-		throw "BigUnsigned::to(Primitive): "
-			"Value is too big to fit in the requested type";
+inline BigUnsigned::WidestUnsigned BigUnsigned::lowBits() const {
+	const Index maxBlocks = sizeof(WidestUnsigned) / sizeof(Blk);
+	WidestUnsigned w = 0;
+	for (Index i = (len < maxBlocks) ? len : maxBlocks; i > 0; ) {
+		i--;
+		// In two steps, in case WidestUnsigned is no wider than a block
+		w = ((w << (N - 1)) << 1) | blk[i];
+	}
+	return w;
 }
 
 #endif
@@ -27,6 +27,20 @@ namespace {
 	unsigned int ceilingDiv(unsigned int a, unsigned int b) {
 		return (a + b - 1) / b;
 	}
+
+	/* Both conversions work with chunks of digits: the largest power of the
+	 * base that fits in a block, base^digits (10^19 for base 10 and 64-bit
+	 * blocks), is one chunk.  Each chunk costs one pass of
+	 * BigUnsigned::divideBlock or multiplyBlock over the number, and the
+	 * digits within it are split off with ordinary block arithmetic. */
+	BigUnsigned::Blk chunkOf(BigUnsignedInABase::Base base,
+			unsigned int &digits) {
+		BigUnsigned::Blk chunk = base;
+		for (digits = 1; chunk <= BigUnsigned::Blk(~BigUnsigned::Blk(0)) / base;
+				digits++)
+			chunk *= base;
+		return chunk;
+	}
 }
 
 BigUnsignedInABase::BigUnsignedInABase(const BigUnsigned &x, Base base) {
@@ -35,37 +49,56 @@ BigUnsignedInABase::BigUnsignedInABase(const BigUnsigned &x, Base base) {
 		throw "BigUnsignedInABase(BigUnsigned, Base): The base must be at least 2";
 	this->base = base;
 
+	unsigned int chunkDigits;
+	BigUnsigned::Blk chunk = chunkOf(base, chunkDigits);
+
 	// Get an upper bound on how much space we need
 	int maxBitLenOfX = x.getLength() * BigUnsigned::N;
 	int minBitsPerDigit = bitLen(base) - 1;
 	int maxDigitLenOfX = ceilingDiv(maxBitLenOfX, minBitsPerDigit);
-	len = maxDigitLenOfX; // Another change to comply with `staying in bounds'.
+	// The last chunk may add up to chunkDigits - 1 leading zeros.
+	len = maxDigitLenOfX + chunkDigits;
 	allocate(len); // Get the space
 
-	BigUnsigned x2(x), buBase(base);
+	BigUnsigned x2(x);
 	Index digitNum = 0;
 
 	while (!x2.isZero()) {
-		// Get last digit.  This is like `lastDigit = x2 % buBase, x2 /= buBase'.
-		BigUnsigned lastDigit(x2);
-		lastDigit.divideWithRemainder(buBase, x2);
-		// Save the digit.
-		blk[digitNum] = lastDigit.toUnsignedShort();
-		// Move on.  We can't run out of room: we figured it out above.
-		digitNum++;
+		// Get the last chunk.  This is like `r = x2 % chunk, x2 /= chunk'.
+		BigUnsigned::Blk r = x2.divideBlock(x2, chunk);
+		// Split it into digits, least significant first.
+		for (unsigned int i = 0; i < chunkDigits; i++) {
+			blk[digitNum] = Digit(r % base);
+			r /= base;
+			digitNum++;
+		}
 	}
 
 	// Save the actual length.
 	len = digitNum;
+	zapLeadingZeros();
 }
 
 BigUnsignedInABase::operator BigUnsigned() const {
-	BigUnsigned ans(0), buBase(base), temp;
+	unsigned int chunkDigits;
+	chunkOf(base, chunkDigits);
+	BigUnsigned ans;
 	Index digitNum = len;
+	// The top chunk takes whatever digits are left over from the others.
+	unsigned int n = len % chunkDigits;
+	if (n == 0)
+		n = chunkDigits;
 	while (digitNum > 0) {
-		digitNum--;
-		temp.multiply(ans, buBase);
-		ans.add(temp, BigUnsigned(blk[digitNum]));
+		BigUnsigned::Blk value = 0, scale = 1;
+		for (; n > 0; n--) {
+			digitNum--;
+			value = value * base + blk[digitNum];
+			scale *= base;
+		}
+		// scale is chunk except for the top chunk, when ans is still 0.
+		ans.multiplyBlock(ans, scale);
+		ans.addBlock(ans, value);
+		n = chunkDigits;
 	}
 	return ans;
 }
@@ -65,6 +65,14 @@ public:
 	// Assignment operator
 	void operator=(const NumberlikeArray<Blk> &x);
 
+	// Exchanges the contents of two arrays without copying any blocks.
+	void swap(NumberlikeArray<Blk> &x) {
+		Index c = cap, l = len;
+		Blk *b = blk;
+		cap = x.cap; len = x.len; blk = x.blk;
+		x.cap = c; x.len = l; x.blk = b;
+	}
+
 	// Constructor that copies from a given array of blocks
 	NumberlikeArray(const Blk *b, Index blen);
 
@@ -6,67 +6,52 @@
 #include <QRegularExpression>
 #include "bigintegermath.h"
 #include "BigIntegerUtils.hh"
+#include "BigIntegerAlgorithms.hh"
 
 BigInteger BigIntegerMath::pow(const BigInteger &base, int exponent)
 {
     BigInteger result;
 
-    if (exponent < 1) {
-        // It don't support floating point
-        result = 1;
-        return result;
-    } else if (exponent == 1) {
-        return base;
-    }
-
-    BigInteger x = base;
-    BigInteger y = 1;
-    int n = exponent;
-
-    while (n > 1) {
-        if ((n & 1) == 0) { // even number
-            x = x * x;
-            n = n / 2;
-        } else {
-            y = x * y;
-            x = x * x;
-            n = ( n - 1) / 2;
-        }
-    }
-
-    result = x * y;
+    // It don't support floating point, so negative exponents give 1.
+    result.pow(base, exponent < 1 ? 0 : exponent);
     return result;
 }
 
-static BigInteger _gcd(const BigInteger &a, const BigInteger &b) {
-    if (a == 0) {
-        return b;
-    }
+BigInteger BigIntegerMath::gcd(const BigInteger &a, const BigInteger &b)
+{
+    // The gcd of the magnitudes; see BigIntegerAlgorithms.cc
+    return ::gcd(a.getMagnitude(), b.getMagnitude());
+}
 
-    if (b == 0) {
-        return a;
+BigInteger BigIntegerMath::factorial(int n)
+{
+    if (n < 1) {
+        return 1;
     }
+    return ::factorial(n);
+}
 
-    if (a > b) {
-        return _gcd(b , a % b);
-    } else {
-        return _gcd(a , b % a);
+BigInteger BigIntegerMath::binomial(int n, int k)
+{
+    if (k < 0 || n < k) {
+        return 0;
     }
+    return ::binomial(n, k);
 }
 
-BigInteger BigIntegerMath::gcd(const BigInteger &a, const BigInteger &b)
+BigInteger BigIntegerMath::multinomial(const QList<int> &ks)
 {
-    BigInteger v1,v2;
-    v1 = a;
-    v2 = b;
-    if (v1 < 0) {
-        v1 = -v1;
-    }
-    if (v2 < 0) {
-        v2 = -v2;
+    QVector<unsigned long> values;
+    values.reserve(ks.size());
+
+    for (int i = 0 ; i < ks.size() ; i++) {
+        if (ks.at(i) < 0) {
+            return 0;
+        }
+        values.append(ks.at(i));
     }
 
-    return _gcd(v1,v2);
+    return ::multinomial(values.constData(), values.size());
 }
 
 void BigIntegerMath::fraction(double input, BigInteger &numerator, BigInteger &denominator, bool normalize)
@@ -14,6 +14,15 @@ public:
 
     static BigInteger gcd(const BigInteger &a,const BigInteger &b);
 
+    /// n!, or 1 for n < 1
+    static BigInteger factorial(int n);
+
+    /// n choose k, or 0 unless 0 <= k <= n
+    static BigInteger binomial(int n,int k);
+
+    /// (k1 + k2 + ...)! / (k1! k2! ...), or 0 if any k is negative
+    static BigInteger multinomial(const QList<int> &ks);
+
     static void fraction(double decimal,
                          BigInteger& numerator,
                          BigInteger& denominator,
@@ -22,6 +31,19 @@ public:
 
 QDebug operator<< (QDebug d, const BigInteger &bigInteger);
 
+/// Hashes for QHash and QSet; see BigUnsigned::hashValue
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+inline size_t qHash(const BigInteger &key, size_t seed = 0)
+{
+    return size_t(key.hashValue(seed));
+}
+#else
+inline uint qHash(const BigInteger &key, uint seed = 0)
+{
+    return uint(key.hashValue(seed));
+}
+#endif
+
 Q_DECLARE_METATYPE(BigInteger)
 
 #endif // BIGINTEGERMATH_H
@@ -134,6 +134,24 @@ void BigIntegerUnitTests::gcd_data()
 
 }
 
+void BigIntegerUnitTests::combinatorics()
+{
+    QString result;
+
+    result = QString::fromStdString(bigIntegerToString(BigIntegerMath::factorial(25)));
+    QVERIFY(result == "15511210043330985984000000");
+
+    result = QString::fromStdString(bigIntegerToString(BigIntegerMath::binomial(100, 50)));
+    QVERIFY(result == "100891344545564193334812497256");
+
+    QVERIFY(BigIntegerMath::binomial(5, 6) == 0);
+
+    QList<int> ks;
+    ks << 3 << 4 << 5;
+    result = QString::fromStdString(bigIntegerToString(BigIntegerMath::multinomial(ks)));
+    QVERIFY(result == "27720");
+}
+
 void BigIntegerUnitTests::fraction()
 {
     QFETCH(qreal, decimal);
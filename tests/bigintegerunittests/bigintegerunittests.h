@@ -23,6 +23,8 @@ private Q_SLOTS:
     void gcd();
     void gcd_data();
 
+    void combinatorics();
+
     void fraction();
     void fraction_data();
 
@@ -113,6 +113,23 @@ TEST(BigUnsigned(0).toShort()); //0
 TEST(BigUnsigned(32767).toShort()); //32767
 TEST(BigUnsigned(32768).toShort()); //error
 
+TEST(BigUnsigned(18446744073709551615ULL).toUnsignedLongLong()); //18446744073709551615
+TEST(BigUnsigned(18446744073709551615ULL).fitsInLongLong()); //0
+TEST(BigUnsigned(9223372036854775807LL).toLongLong()); //9223372036854775807
+TEST(BigUnsigned(-1LL)); //error
+TEST(BigUnsigned(65536).fitsInUnsignedShort()); //0
+TEST(BigUnsigned(65535).fitsInUnsignedShort()); //1
+#ifdef __SIZEOF_INT128__
+{
+	BigUnsigned::UInt128 u128 = ~BigUnsigned::UInt128(0);
+	TEST(check(BigUnsigned(u128))); //340282366920938463463374607431768211455
+	TEST(BigUnsigned(u128).toUnsignedInt128() == u128); //1
+	TEST(BigUnsigned(u128).fitsInInt128()); //0
+	TEST(BigUnsigned(u128 >> 1).toInt128() == BigUnsigned::Int128(u128 >> 1)); //1
+	TEST((BigUnsigned(u128) + 1).toUnsignedInt128() == 0); //error
+}
+#endif
+
 // === BigInteger conversion limits ===
 
 TEST(BigInteger(-1).toUnsignedLong()); //error
@@ -152,6 +169,23 @@ TEST(BigInteger(0).toShort()); //0
 TEST(BigInteger(32767).toShort()); //32767
 TEST(BigInteger(32768).toShort()); //error
 
+TEST(check(BigInteger(-9223372036854775807LL - 1))); //-9223372036854775808
+TEST(BigInteger(-9223372036854775807LL - 1).toLongLong()); //-9223372036854775808
+TEST(stringToBigInteger("-9223372036854775809").fitsInLongLong()); //0
+TEST(BigInteger(-1LL).toUnsignedLongLong()); //error
+TEST(BigInteger(18446744073709551615ULL).toUnsignedLongLong()); //18446744073709551615
+TEST(BigInteger(-32768).fitsInShort()); //1
+TEST(BigInteger(-32769).fitsInShort()); //0
+#ifdef __SIZEOF_INT128__
+{
+	BigUnsigned::Int128 i128min = -BigUnsigned::Int128(~BigUnsigned::UInt128(0) >> 1) - 1;
+	TEST(check(BigInteger(i128min))); //-170141183460469231731687303715884105728
+	TEST(BigInteger(i128min).toInt128() == i128min); //1
+	TEST((BigInteger(i128min) - 1).fitsInInt128()); //0
+	TEST(BigInteger(i128min).toUnsignedInt128() == 0); //error
+}
+#endif
+
 // === Negative BigUnsigneds ===
 
 // ...during construction
@@ -250,6 +284,71 @@ TEST(bbb); //4294967321
 bbb.setBit(31, true);
 bbb.setBit(32, false);
 TEST(check(bbb)); //2147483673
+TEST(bbb.popcount()); //4
+TEST(bbb.countTrailingZeros()); //0
+TEST(BigUnsigned(40).countTrailingZeros()); //3
+TEST(BigUnsigned(0).countTrailingZeros()); //0
+TEST(BigUnsigned(0).lowestSetBit()); //error
+TEST((BigUnsigned(5) << 100).lowestSetBit()); //100
+TEST((BigUnsigned(1) << 200).bitLength()); //201
+TEST(((BigUnsigned(1) << 200) - 1).popcount()); //200
+
+// Bit ranges
+TEST(BigUnsigned(25).extractBits(1, 3)); //4
+TEST(BigUnsigned(25).getBits(0, 65)); //error
+{
+	BigUnsigned br = (BigUnsigned(1) << 130) - 1;
+	TEST(br.getBits(60, 8)); //255
+	TEST(br.extractBits(10, 200) == (BigUnsigned(1) << 120) - 1); //1
+	br.clearBitRange(64, 64);
+	TEST(check(br).popcount()); //66
+	TEST(br.testAnyInRange(64, 64)); //0
+	TEST(br.testAnyInRange(60, 5)); //1
+	br.clearBitRange(100, 1000);
+	TEST(check(br)); //18446744073709551615
+	br.setBitRange(200, 3);
+	TEST(check(br).bitLength()); //203
+	br.insertBits(4, 0, 8);
+	TEST(check(br)); //11248566309812931928793734646388138217655439403223623556657167
+	br.insertBits(62, 5, 4);
+	TEST(check(br)); //11248566309812931928793734646388138217655448626595660411432975
+	br.insertBits(300, br, 10);
+	TEST(check(br)); //30555539645017291294026685326151920982081838836917837494188494878533374945076646253162393615
+}
+
+// === BigInteger bitwise operators ===
+
+TEST(BigInteger(-6) & 3); //2
+TEST(BigInteger(-6) | 3); //-5
+TEST(BigInteger(-6) ^ 3); //-7
+TEST(BigInteger(-6) & -3); //-8
+TEST(BigInteger(6) ^ 6); //0
+TEST(~BigInteger(5)); //-6
+TEST(~BigInteger(-1)); //0
+TEST(~BigInteger(0)); //-1
+TEST(BigInteger(-7) >> 1); //-4
+TEST(BigInteger(-8) >> 3); //-1
+TEST(BigInteger(7) >> 1); //3
+TEST(BigInteger(-1) >> 100); //-1
+TEST(BigInteger(-3) << 2); //-12
+TEST(BigInteger(-3) << -1); //-2
+TEST(check(BigInteger(0) << 130)); //0
+TEST(BigInteger(5) << pathologicalInt); //error
+{
+	BigInteger ba = -(BigInteger(1) << 130) + 12345;
+	BigInteger bb = (BigInteger(1) << 100) - 1;
+	TEST(check(ba & bb)); //12345
+	TEST(check(ba | bb)); //-1361129466416103253625269028230369640449
+	TEST(check(ba ^ bb)); //-1361129466416103253625269028230369652794
+	TEST(check(~ba)); //1361129467683753853853498429727072833478
+	TEST(check(ba >> 70)); //-1152921504606846976
+	TEST(check(ba >> 200)); //-1
+	TEST(check(-(BigInteger(1) << 128) & -(BigInteger(1) << 64))); //-340282366920938463463374607431768211456
+	ba &= ba;
+	TEST(check(ba)); //-1361129467683753853853498429727072833479
+	ba ^= ba;
+	TEST(check(ba)); //0
+}
 
 // === Combining BigUnsigned, BigInteger, and primitive integers ===
 
@@ -265,6 +364,353 @@ TEST(p1); //15
 BigInteger p2 = BigInteger(BigUnsigned(3)) * -5;
 TEST(p2); //-15
 
+// Primitive operands that skip the temporary
+TEST(check(BigUnsigned(~0UL) + 1)); //18446744073709551616
+TEST(check(BigUnsigned(5) - 6)); //error
+TEST(check(BigUnsigned(5) + -1)); //error
+TEST(check(BigInteger(5) - (BigUnsigned(1) << 64))); //-18446744073709551611
+TEST(check(BigInteger(-7) / 2)); //-4
+TEST(check(BigInteger(-7) % 2)); //1
+TEST(check(BigInteger(7) / -2L)); //-4
+TEST(check(BigInteger(7) % -2LL)); //-1
+TEST(BigInteger(7) / 0); //error
+TEST(check((BigUnsigned(1) << 130) / 1000003)); //1361125384307600931050705277611240
+TEST(check((BigUnsigned(1) << 130) % 1000003u)); //12104
+TEST(BigInteger(-3) < 0); //1
+TEST(BigInteger(-3) > -4L); //1
+TEST(BigUnsigned(~0UL) == ~0ULL); //1
+{
+	BigInteger pc(-2);
+	pc += 5;
+	pc *= -4;
+	pc -= -12L;
+	TEST(check(pc)); //0
+	pc -= 1;
+	TEST(check(pc)); //-1
+}
+#ifdef __SIZEOF_INT128__
+TEST(check(BigInteger(1) + BigUnsigned::Int128(~BigUnsigned::UInt128(0) >> 1) - 1)); //170141183460469231731687303715884105727
+TEST(BigInteger(-1) > -(BigUnsigned::Int128(1) << 100)); //1
+#endif
+
+// === Hashing ===
+
+TEST(BigUnsigned(12345).hashValue() == BigInteger(12345).hashValue()); //1
+TEST(BigInteger(12345).hashValue() == BigInteger(-12345).hashValue()); //0
+TEST(BigUnsigned(12345).hashValue(1) == BigUnsigned(12345).hashValue(2)); //0
+TEST(BigUnsigned(0).hashValue() == BigUnsigned(1).hashValue()); //0
+TEST(std::hash<BigInteger>()(BigInteger(-7)) == BigInteger(-7).hashValue()); //1
+{
+	// Blocks 0 and 4 go into the same lane, and shouldn't cancel.
+	BigUnsigned ha = (BigUnsigned(1) << 314) + (BigUnsigned(1) << 58);
+	BigUnsigned hb = (BigUnsigned(1) << 282) + (BigUnsigned(1) << 60);
+	TEST(ha.hashValue() == hb.hashValue()); //0
+	TEST((ha * ha).hashValue() == (ha * ha).hashValue()); //1
+}
+
+// === GCD ===
+
+TEST(gcd(0, 0)); //0
+TEST(gcd(0, 12)); //12
+TEST(gcd(12, 18)); //6
+TEST(gcd((BigUnsigned(1) << 200) - 1, (BigUnsigned(1) << 150) - 1)); //1125899906842623
+TEST(gcd(stringToBigUnsigned("1813413944153750138980"), stringToBigUnsigned("1813413944153750139968"))); //988
+TEST(gcd(stringToBigUnsigned("8320987112741390144276341183223364380754172606361245952449277696409600000000000000"), stringToBigUnsigned("739044147071729616580416051031916488005"))); //114383962274805
+TEST(gcd(stringToBigUnsigned("145752050614077475913031745536"), stringToBigUnsigned("36438012985560762305029865472"))); //332041393326771929088
+// Big enough for the half-gcd recursion
+TEST(gcd((BigUnsigned(1) << 12800) - 1, (BigUnsigned(1) << 9600) - 1).bitLength()); //3200
+TEST(gcd(((BigUnsigned(1) << 8000) - 1) * 6, ((BigUnsigned(1) << 8000) - 1) * 15).bitLength()); //8002
+
+{
+	BigInteger g, r, s;
+	extendedEuclidean(240, 46, g, r, s);
+	TEST(g); //2
+	TEST(r); //-9
+	TEST(s); //47
+	extendedEuclidean(46, 240, g, r, s);
+	TEST(r); //47
+	TEST(s); //-9
+	BigInteger m((BigUnsigned(1) << 9000) + 7), n((BigUnsigned(1) << 8500) + 3);
+	extendedEuclidean(m, n, g, r, s);
+	TEST(g); //1
+	TEST(r * m + s * n); //1
+}
+
+// === Modular arithmetic ===
+
+TEST(modinv(3, 7)); //5
+TEST(modinv(-3, 7)); //2
+TEST(modinv(6, 9)); //error
+TEST(modinv(5, 1)); //0
+{
+	BigUnsigned m = (BigUnsigned(1) << 521) - 1;
+	TEST(modinv(3, m) * 3 % m); //1
+}
+
+{
+	BigInteger values[4] = { 3, -3, 10, 1000000 };
+	BigUnsigned inverses[4];
+	batchModinv(values, 4, 1000000007, inverses);
+	TEST(inverses[0]); //333333336
+	TEST(inverses[1]); //666666671
+	TEST(inverses[2]); //700000005
+	TEST(inverses[3]); //142857001
+	values[2] = 1000000007;
+	TEST((batchModinv(values, 4, 1000000007, inverses), 0)); //error
+}
+
+TEST(modexp(4, 13, 497)); //445
+TEST(modexp(3, 100, stringToBigUnsigned("1208925819614629174706178"))); //315977665856322851790159
+
+{
+	BigInteger bases[3] = { 2, 3, -5 };
+	BigUnsigned exponents[3] = { 100, 200, 3 };
+	TEST(multiExp(bases, exponents, 3, 1000000007)); //223495250
+	TEST(multiExp(bases, exponents, 0, 1000000007)); //1
+}
+
+{
+	FixedBaseExp f(5, 1000000007);
+	TEST(f.pow(123456789)); //372224738
+	TEST(f.pow(0)); //1
+	// Exponents beyond the table still work.
+	TEST(f.pow(stringToBigUnsigned("1099511627779"))); //316476643
+}
+
+{
+	BarrettReducer r(1000000007);
+	TEST(r.reduce(stringToBigUnsigned("999999999999999999"))); //48
+	// An even modulus two blocks long, with the largest input below m^2
+	BarrettReducer r2(stringToBigUnsigned("184467440737095516160"));
+	TEST(r2.reduce(stringToBigUnsigned("34028236692093846345968525861702630113281"))); //1
+	// Inputs longer than 2k blocks fall back to division.
+	TEST(r2.reduce(stringToBigUnsigned("515377520732011331036461129765621272702107522001"))); //70802353449300661201
+	// Reduction modulo zero leaves the input alone.
+	BarrettReducer r0(0);
+	TEST(r0.reduce(12345)); //12345
+	// Moduli this long get their reciprocal by Newton's iteration.
+	BigUnsigned m = (BigUnsigned(1) << 40000) - 3;
+	BarrettReducer r3(m);
+	TEST(r3.reduce(m * m - 1) == m - 1); //1
+	TEST(r3.reduce((m + 5) * (m - 7)) == m - 35); //1
+	// The quotient comes along when asked for.
+	BigUnsigned q;
+	TEST(r.reduce(stringToBigUnsigned("999999999999999999"), q)); //48
+	TEST(q); //999999993
+	TEST(r2.reduce(stringToBigUnsigned("34028236692093846345968525861702630113281"), q)); //1
+	TEST(q); //184467440737095516158
+	TEST(r3.reduce(m * m - 1, q) == m - 1 && q == m - 1); //1
+	m = BigUnsigned(1) << 31999;
+	BarrettReducer r4(m);
+	TEST(r4.reduce(m * m - 1) == m - 1); //1
+}
+
+// === Division ===
+
+TEST(stringToBigUnsigned("340282366920938463463374607431768211455") / stringToBigUnsigned("18446744073709551617")); //18446744073709551615
+TEST(stringToBigUnsigned("340282366920938463463374607431768211455") % stringToBigUnsigned("18446744073709551617")); //0
+// The estimated quotient block is one too large, so the divisor is added back.
+TEST(stringToBigUnsigned("57896044618658097708646941636650613544717097621216448811677614281724547563520") / stringToBigUnsigned("3138550867693340381917894711603833208051177722232017256449")); //18446744073709551614
+TEST(stringToBigUnsigned("57896044618658097708646941636650613544717097621216448811677614281724547563520") % stringToBigUnsigned("3138550867693340381917894711603833208051177722232017256449")); //3138550867693340381917894711603833208032730978158307704834
+
+// === Base conversion ===
+
+// Digits are converted 19 at a time for base 10; these straddle the chunks.
+TEST(stringToBigUnsigned("10000000000000000000")); //10000000000000000000
+TEST(stringToBigUnsigned("9999999999999999999")); //9999999999999999999
+TEST(stringToBigUnsigned("100000000000000000000000000000000000001")); //100000000000000000000000000000000000001
+TEST(stringToBigUnsigned("0000000000000000000000000000000000000012")); //12
+TEST(string(BigUnsignedInABase(BigUnsigned(1) << 130, 36))); //1OMFRO7ZWMUMR3UMXUDZYJ6SCG
+TEST(BigUnsigned(BigUnsignedInABase("1OMFRO7ZWMUMR3UMXUDZYJ6SCG", 36)) == (BigUnsigned(1) << 130)); //1
+{
+	// Long numbers are split in halves by powers of 10^19 on the way out.
+	BigUnsigned x;
+	x.pow(10, 5000);
+	string s = bigUnsignedToString(x);
+	TEST(s.length()); //5001
+	TEST(s.find_first_not_of('0', 1) == string::npos); //1
+	TEST(stringToBigUnsigned(bigUnsignedToString(x - 1)) == x - 1); //1
+	x.pow(3, 20000);
+	TEST(stringToBigUnsigned(bigUnsignedToString(x)) == x); //1
+}
+{
+	BigUnsigned x = stringToBigUnsigned("123456789012345678901234567890");
+	BigUnsignedInABase y(x, 65535);
+	TEST(y.getLength()); //7
+	TEST(BigUnsigned(y) == x); //1
+}
+
+// === Powers ===
+
+{
+	BigUnsigned x;
+	x.pow(3, 40); TEST(check(x)); //12157665459056928801
+	x.pow(12, 30); TEST(check(x)); //237376313799769806328950291431424
+	x.pow(2, 100); TEST(check(x)); //1267650600228229401496703205376
+	x.pow(0, 0); TEST(check(x)); //1
+	x.pow(0, 5); TEST(check(x)); //0
+	x.pow(stringToBigUnsigned("18446744073709551617"), 3); TEST(check(x)); //6277101735386680764856636523970481806547819498980467802113
+	x.pow(x, 2); TEST(check(x)); //39402006196394479225094962315669074301186750846042502287043627348223690624260330052300160475434731109528296927264769
+	BigInteger y;
+	y.pow(-6, 21); TEST(check(y)); //-21936950640377856
+	y.pow(-10, 0); TEST(check(y)); //1
+	y.pow(10, 25); TEST(check(y)); //10000000000000000000000000
+}
+
+// === Roots ===
+
+TEST(isqrt(0)); //0
+TEST(isqrt(15)); //3
+TEST(isqrt(16)); //4
+TEST(isqrt(stringToBigUnsigned("340282366920938463463374607431768211455"))); //18446744073709551615
+{
+	BigUnsigned s, r;
+	isqrtRem(stringToBigUnsigned("1000000000000000000000000000000"), s, r);
+	TEST(s); //1000000000000000
+	TEST(r); //0
+	isqrtRem(99, s, r);
+	TEST(s); //9
+	TEST(r); //18
+}
+TEST(iroot(stringToBigUnsigned("1000000000000000000000000000000"), 3)); //10000000000
+TEST(iroot(stringToBigUnsigned("999999999999999999999999999999"), 3)); //9999999999
+TEST(iroot(12345, 1)); //12345
+TEST(iroot(12345, 100)); //1
+TEST(iroot(12345, 0)); //error
+TEST(isPerfectSquare(0)); //1
+TEST(isPerfectSquare(stringToBigUnsigned("152415787532388367501905199875019052100"))); //1
+TEST(isPerfectSquare(stringToBigUnsigned("152415787532388367501905199875019052101"))); //0
+TEST(perfectPowerExponent(1)); //0
+TEST(perfectPowerExponent(12)); //1
+TEST(perfectPowerExponent(BigUnsigned(1) << 90)); //90
+TEST(perfectPowerExponent(stringToBigUnsigned("1000000000000000000000000000000"))); //30
+TEST(perfectPowerExponent(stringToBigUnsigned("1000000000000000000000000000001"))); //1
+
+// === Primality ===
+
+TEST(isProbablePrime(0, 0)); //0
+TEST(isProbablePrime(2, 0)); //1
+TEST(isProbablePrime(997, 0)); //1
+TEST(isProbablePrime(999983, 0)); //1
+/* Strong pseudoprimes to base 2 with no factor below 1000: they pass
+ * Miller-Rabin to base 2, so the strong Lucas test rejects them.  The
+ * second is also a strong pseudoprime to the extra bases 3, 5 and 7. */
+TEST(isProbablePrime(25326001, 0)); //0
+TEST(isProbablePrime(3825123056546413051UL, 3)); //0
+/* A strong Lucas pseudoprime with no factor below 1000, which Miller-Rabin
+ * to base 2 rejects. */
+TEST(isProbablePrime(1711469, 0)); //0
+TEST(isProbablePrime((BigUnsigned(1) << 521) - 1, 3)); //1
+TEST(isProbablePrime((BigUnsigned(1) << 523) - 1, 3)); //0
+TEST(nextPrime(0)); //2
+TEST(nextPrime(2)); //3
+TEST(nextPrime(113)); //127
+TEST(nextPrime(stringToBigUnsigned("18446744073709551557"))); //18446744073709551629
+{
+	NumberlikeArray<BigUnsigned> primes = primesInRange(90, 128);
+	TEST(primes.getLength()); //7
+	TEST(primes.getBlock(0)); //97
+	TEST(primes.getBlock(6)); //127
+	TEST(primesInRange(stringToBigUnsigned("1000000000000000000000"), stringToBigUnsigned("1000000000000000000200")).getLength()); //2
+}
+
+// === Combinatorics ===
+
+TEST(factorial(0)); //1
+TEST(factorial(25)); //15511210043330985984000000
+TEST(factorial(1000).bitLength()); //8530
+TEST(binomial(100, 50)); //100891344545564193334812497256
+TEST(binomial(5, 6)); //0
+TEST(binomial(1000, 400).bitLength()); //966
+// Huge n with a small k takes a running product instead of a sieve.
+TEST(binomial(4294967296UL, 2)); //9223372034707292160
+TEST(binomial(1UL << 40, 100) % 1000003); //854437
+TEST(binomial(~0UL, 1)); //18446744073709551615
+TEST(binomial(~0UL, ~0UL / 2)); //error
+TEST(factorial(~0UL)); //error
+{
+	unsigned long ks[3] = { 3, 4, 5 };
+	TEST(multinomial(ks, 3)); //27720
+	unsigned long ks2[2] = { ~0UL - 1, 1 };
+	TEST(multinomial(ks2, 2)); //18446744073709551615
+}
+
+// === Fibonacci and Lucas numbers ===
+
+TEST(fibonacci(0)); //0
+TEST(fibonacci(1)); //1
+TEST(fibonacci(100)); //354224848179261915075
+TEST(lucas(0)); //2
+TEST(lucas(100)); //792070839848372253127
+TEST(fibonacci(10000).bitLength()); //6942
+TEST(fibonacciMod(stringToBigUnsigned("1000000000000000000000"), 1000000007)); //124177063
+TEST(lucasMod(100, 1000)); //127
+TEST(fibonacciMod(100, 1)); //0
+TEST(fibonacciMod(100, 0)); //error
+
+// === Product and remainder trees ===
+
+{
+	BigUnsigned moduli[6] = { 3, 5, 7, 11, 13, 0 }, remainders[6];
+	TEST(productTree(moduli, 5)); //15015
+	TEST(productTree(moduli, 6)); //0
+	TEST(productTree(moduli, 0)); //1
+	remainderTree(1000000, moduli, 6, remainders);
+	TEST(remainders[0]); //1
+	TEST(remainders[1]); //0
+	TEST(remainders[2]); //1
+	TEST(remainders[4]); //1
+	TEST(remainders[5]); //1000000
+	BigUnsigned big[3] = { 1000000007, 998244353, stringToBigUnsigned("18446744073709551617") };
+	TEST(productTree(big, 3)); //18414358231717282383549698447825881607
+	remainderTree(BigUnsigned(1) << 200, big, 3, remainders);
+	TEST(remainders[0]); //499445072
+	TEST(remainders[1]); //982924732
+	TEST(remainders[2]); //18446744073709551361
+}
+
+{
+	BigUnsigned moduli[6] = { 15, 21, 35, 143, 17, 1 }, gcds[6];
+	batchGcd(moduli, 6, gcds);
+	TEST(gcds[0]); //15
+	TEST(gcds[1]); //21
+	TEST(gcds[2]); //35
+	TEST(gcds[3]); //1
+	TEST(gcds[5]); //1
+	BigUnsigned p = nextPrime(BigUnsigned(1) << 80), q = nextPrime(BigUnsigned(1) << 81),
+		r = nextPrime(BigUnsigned(1) << 82), s = nextPrime(BigUnsigned(1) << 83);
+	moduli[0] = p * q;
+	moduli[1] = r * s;
+	moduli[2] = p * r;
+	batchGcd(moduli, 3, moduli);
+	TEST(moduli[0] == p); //1
+	TEST(moduli[1] == r); //1
+	TEST(moduli[2] == p * r); //1
+	moduli[1] = 0;
+	TEST((batchGcd(moduli, 3, gcds), 0)); //error
+}
+
+// === Jacobi symbols and modular square roots ===
+
+TEST(jacobi(2, 15)); //1
+TEST(jacobi(-1, 7)); //-1
+TEST(jacobi(6, 9)); //0
+TEST(jacobi(1001, 9907)); //-1
+TEST(jacobi(5, 10)); //error
+TEST(modSqrt(2, 7)); //3
+TEST(modSqrt(10, 13)); //6
+TEST(modSqrt(5, 13)); //error
+TEST(modSqrt(2, 17)); //6
+TEST(modSqrt(3, 2)); //1
+// Squares of odd primes have no non-square residues to start Tonelli-Shanks.
+TEST(modSqrt(4, 9)); //error
+TEST(modSqrt(2, 49)); //error
+// Composites that the p == 5 mod 8 and p == 3 mod 4 formulas would miss
+TEST(modSqrt(4, 21)); //error
+TEST(modSqrt(2, 15)); //error
+// p == 5 mod 8
+TEST(modSqrt(-1, (BigUnsigned(1) << 255) - 19)); //19681161376707505956807079304988542015446066515923890162744021073123829784752
+
 // === Test some previous bugs ===
 
 {